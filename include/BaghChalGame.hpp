@@ -1,10 +1,15 @@
 #pragma once
 
+#include <array>
+#include <bitset>
 #include <optional>
 #include <string>
 #include <vector>
 
+#include <BoardSymmetries.hpp>
 #include <Game.hpp>
+#include <Network.hpp>
+#include <Parameters.hpp>
 
 using namespace std;
 
@@ -36,6 +41,10 @@ class BaghChalMove : public GameMove {
     BaghChalMove(BaghChalCell ci_, BaghChalCell cf_) : ci(ci_), cf(cf_) {}
     BaghChalMove(int xi, int yi, int xf, int yf) : BaghChalMove(BaghChalCell(xi, yi), BaghChalCell(xf, yf)) {}
 
+    bool operator==(const BaghChalMove &m) const {
+        return ci == m.ci and cf == m.cf;
+    }
+
     operator string() const override {
         if (cf == BaghChalCell(-1, -1)) {
             return string(ci);
@@ -45,6 +54,12 @@ class BaghChalMove : public GameMove {
     }
 };
 
+template <> struct std::hash<BaghChalMove> {
+    size_t operator()(const BaghChalMove &m) const {
+        return std::hash<int>()(((m.ci.x + 1) * 16 + (m.ci.y + 1)) * 256 + (m.cf.x + 1) * 16 + (m.cf.y + 1));
+    }
+};
+
 class BaghChalState : public GameState {
   private:
     long long state_;
@@ -127,9 +142,24 @@ class BaghChalGame : public Game<BaghChalState, BaghChalMove> {
         return abs(cf.x - ci.x) + abs(cf.y - ci.y);
     }
 
+    /* Returns the cell mapped by the given symmetry. Cells outside the board are kept. */
+    static BaghChalCell get_symmetric_cell(BaghChalCell c, int symmetry) {
+        return is_inside(c) ? get_symmetric_board_cell<N, N>(c, symmetry) : c;
+    }
+
+    /* Inputs of the evaluation network: a sheep on each cell, a wolf on each cell, the sheeps on hand (0 to 20) and SHEEP to move. */
+    static constexpr int NETWORK_INPUTS = 2 * N * N + 21 + 1;
+
+    /* Returns the digit of a cell in the encoded state. */
+    static int get_digit(int cell) {
+        return cell == SHEEP ? 0 : (cell == WOLF ? 1 : 2);
+    }
+
     int board[N][N]; // Board.
     int sheeps;      // Sheeps to be placed on the board.
 
+    Network<NETWORK_INPUTS>::AccumulatorStack accumulators; // First layer of the evaluation network along the current line, if it is loaded.
+
     /* Returns true if SHEEP player is still placing sheeps on the board. */
     bool is_first_phase() const;
 
@@ -154,6 +184,15 @@ class BaghChalGame : public Game<BaghChalState, BaghChalMove> {
     /* Returns all the possible moves for the current state of the game. */
     vector<BaghChalMove> get_moves_for_(int) const;
 
+    /* Returns the given board and the rest of the current game state converted to State. */
+    BaghChalState encode_state(const int (&)[N][N]) const;
+
+    /* Returns the inputs of the evaluation network for the current board with the given player to move. */
+    bitset<NETWORK_INPUTS> encode_network_inputs(int) const;
+
+    /* Updates the accumulators of the evaluation network after the board changes, with the given player to move. */
+    void update_accumulators(int);
+
   protected:
     /* Returns the current game state converted to State. */
     BaghChalState get_state_() const override;
@@ -173,13 +212,43 @@ class BaghChalGame : public Game<BaghChalState, BaghChalMove> {
     /* Returns the winner. */
     using Game<BaghChalState, BaghChalMove>::get_winner_;
 
+    /* Returns the smallest of the states that are symmetric to the current one, and the symmetry that maps the current state into it. */
+    pair<BaghChalState, int> get_canonical_state_() const override;
+
+    /* Returns the move mapped by the given symmetry. */
+    BaghChalMove get_symmetric_move_(const BaghChalMove &, int) const override;
+
+    /* Returns the symmetry that undoes the given symmetry. */
+    int get_inverse_symmetry_(int) const override;
+
+    /* Returns true if the move is a capture. */
+    bool is_forcing_move_(const BaghChalMove &) const override;
+
+    /* Returns the captures. */
+    vector<BaghChalMove> get_noisy_moves_() const override;
+
     /* Returns a value between -1 and 1 indicating how probable it is for the first player to win (1.0) or the other player to win (-1.0). */
     double evaluate_() const override;
 
   public:
+    /* Number of evaluation features. */
+    static constexpr int FEATURES = 2;
+
+    /* Evaluation weights, one per feature. Tuned by tools/tune.cpp. */
+    static Parameter weights[FEATURES];
+
+    /* Optional evaluation network, used instead of the weighted features once loaded. Trained by tools/train.cpp. */
+    static Network<NETWORK_INPUTS> network;
+
     BaghChalGame();
     BaghChalGame(const BaghChalState &);
 
+    /* Returns the evaluation features (stuck wolves and dead sheeps), pretending that we are SHEEP. */
+    array<double, FEATURES> get_features() const;
+
+    /* Returns the inputs of the evaluation network. */
+    bitset<NETWORK_INPUTS> get_network_inputs() const;
+
     /* Returns true if the movement is valid. */
     bool is_valid_move(const BaghChalMove &) const override;
 
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+using namespace std;
+
+/* Unsigned integer with at least the given number of bits, up to 128, for boards and states encoded as bits. Board sizes that fit in 64 bits
+   keep using uint64_t. */
+template <int BITS> using Bitboard = conditional_t<(BITS <= 64), uint64_t, unsigned __int128>;
+
+/* Returns the number of bits set. */
+inline int count_bits(uint64_t bits) {
+    return __builtin_popcountll(bits);
+}
+
+inline int count_bits(unsigned __int128 bits) {
+    return __builtin_popcountll(static_cast<uint64_t>(bits)) + __builtin_popcountll(static_cast<uint64_t>(bits >> 64));
+}
+
+/* Returns the hash of the bits. 64 bit values hash as themselves, like std::hash. */
+inline size_t hash_bits(uint64_t bits) {
+    return std::hash<uint64_t>()(bits);
+}
+
+inline size_t hash_bits(unsigned __int128 bits) {
+    return std::hash<uint64_t>()(static_cast<uint64_t>(bits) ^ static_cast<uint64_t>(bits >> 64) * 0x9E3779B97F4A7C15ull);
+}
+
+/* Returns the bits as a decimal number. */
+inline string bits_to_string(uint64_t bits) {
+    return to_string(bits);
+}
+
+inline string bits_to_string(unsigned __int128 bits) {
+    string str;
+
+    do {
+        str += static_cast<char>('0' + static_cast<int>(bits % 10));
+        bits /= 10;
+    } while (bits > 0);
+
+    reverse(str.begin(), str.end());
+    return str;
+}
+
+/* Reads a decimal number written by bits_to_string. Throws invalid_argument if it isn't one, or out_of_range if it doesn't fit. */
+template <class BitsType> BitsType string_to_bits(const string &str) {
+    if (str.empty()) {
+        throw invalid_argument("empty number");
+    }
+
+    BitsType bits = 0;
+
+    for (char c : str) {
+        if (c < '0' or c > '9') {
+            throw invalid_argument("invalid digit in " + str);
+        }
+
+        if (bits > (static_cast<BitsType>(-1) - (c - '0')) / 10) {
+            throw out_of_range(str + " doesn't fit in " + to_string(8 * sizeof(BitsType)) + " bits");
+        }
+
+        bits = bits * 10 + (c - '0');
+    }
+
+    return bits;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+
+using namespace std;
+
+/* Returns the number of lines of K cells (horizontal, vertical and both diagonals) on a board of N rows and M columns. */
+constexpr int count_board_lines(int N, int M, int K) {
+    return N * (M - K + 1) + (N - K + 1) * M + 2 * (N - K + 1) * (M - K + 1);
+}
+
+/* Returns every line of K cells on a board of N rows and M columns as the (x, y) of its cells, going UPRIGHT, RIGHT, DOWNRIGHT or DOWN from its
+   first cell. Evaluated at compile time, so that games can loop over a fixed table instead of checking bounds. */
+template <int N, int M, int K> constexpr array<array<array<int, 2>, K>, count_board_lines(N, M, K)> get_board_lines() {
+    constexpr int DIR[4][2] = {{-1, 1}, {0, 1}, {1, 1}, {1, 0}};
+    array<array<array<int, 2>, K>, count_board_lines(N, M, K)> lines = {};
+    int count = 0;
+
+    for (int x = 0; x < N; x++) {
+        for (int y = 0; y < M; y++) {
+            for (int d = 0; d < 4; d++) {
+                int xf = x + (K - 1) * DIR[d][0], yf = y + (K - 1) * DIR[d][1];
+
+                if (0 <= xf and xf < N and 0 <= yf and yf < M) {
+                    for (int i = 0; i < K; i++) {
+                        lines[count][i][0] = x + i * DIR[d][0];
+                        lines[count][i][1] = y + i * DIR[d][1];
+                    }
+
+                    count++;
+                }
+            }
+        }
+    }
+
+    return lines;
+}
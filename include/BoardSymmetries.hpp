@@ -0,0 +1,56 @@
+#pragma once
+
+using namespace std;
+
+/* Symmetries of the square for boards of N rows and M columns. Bit 0 transposes, bit 1 mirrors x and bit 2 mirrors y, in that order. Rectangular
+   boards can't be transposed, so they only have the even symmetries. */
+constexpr int BOARD_SYMMETRIES = 8;
+
+/* Returns the cell, with coordinates x and y, mapped by the given symmetry. */
+template <int N, int M, class CellType> constexpr CellType get_symmetric_board_cell(CellType c, int symmetry) {
+    if (symmetry & 1) {
+        int x = c.x;
+        c.x = c.y;
+        c.y = x;
+    }
+
+    if (symmetry & 2) {
+        c.x = N - 1 - c.x;
+    }
+
+    if (symmetry & 4) {
+        c.y = M - 1 - c.y;
+    }
+
+    return c;
+}
+
+/* Returns the symmetry that undoes the given symmetry. The mirrors are undone before transposing, which swaps them. */
+constexpr int get_inverse_board_symmetry(int symmetry) {
+    if (symmetry & 1) {
+        return 1 | ((symmetry & 2) << 1) | ((symmetry & 4) >> 1);
+    }
+
+    return symmetry;
+}
+
+/* Returns the symmetry that maps a board into the smallest of its symmetric boards, given the digit of each cell (x, y) in its encoding. The most
+   significant cell, the last one, in which two symmetric boards differ decides which one is smaller. Only every step-th symmetry is considered. */
+template <int N, int M, class CellType, class DigitFunction> int get_smallest_board_symmetry(int step, const DigitFunction &get_digit) {
+    int best_symmetry = 0;
+
+    for (int symmetry = step; symmetry < BOARD_SYMMETRIES; symmetry += step) {
+        for (int p = N * M - 1; p >= 0; p--) {
+            CellType c = get_symmetric_board_cell<N, M>(CellType(p / M, p % M), get_inverse_board_symmetry(symmetry));
+            CellType best_c = get_symmetric_board_cell<N, M>(CellType(p / M, p % M), get_inverse_board_symmetry(best_symmetry));
+            int digit = get_digit(c.x, c.y), best_digit = get_digit(best_c.x, best_c.y);
+
+            if (digit != best_digit) {
+                best_symmetry = digit < best_digit ? symmetry : best_symmetry;
+                break;
+            }
+        }
+    }
+
+    return best_symmetry;
+}
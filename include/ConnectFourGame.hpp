@@ -1,10 +1,15 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <vector>
 
+#include <Bitboard.hpp>
+#include <BoardLines.hpp>
 #include <Game.hpp>
+#include <Parameters.hpp>
 
 class ConnectFourMove : public GameMove {
   public:
@@ -13,76 +18,110 @@ class ConnectFourMove : public GameMove {
     ConnectFourMove() : y(-1) {}
     ConnectFourMove(int y_) : y(y_) {}
 
+    bool operator==(const ConnectFourMove &m) const {
+        return y == m.y;
+    }
+
     operator string() const override {
         return to_string(y);
     }
 };
 
-class ConnectFourState : public GameState {
+template <> struct std::hash<ConnectFourMove> {
+    size_t operator()(const ConnectFourMove &m) const {
+        return std::hash<int>()(m.y);
+    }
+};
+
+/* Bits of a ConnectFour state of N rows and M columns: every column stores one bit per row and one more to mark its height, followed by the player
+   to move. */
+template <int N, int M> constexpr int CONNECT_FOUR_STATE_BITS = M * (N + 1) + 2;
+
+template <int N, int M> class BasicConnectFourState : public GameState {
+  public:
+    using BitsType = Bitboard<CONNECT_FOUR_STATE_BITS<N, M>>;
+
   private:
-    string state_;
+    BitsType state_; // Columns and player to move, encoded by BasicConnectFourGame::encode_state.
 
   public:
-    explicit ConnectFourState(const string &state) {
+    explicit BasicConnectFourState(BitsType state) {
         state_ = state;
-        hash_ = std::hash<string>()(state_);
+        hash_ = hash_bits(state_);
     }
 
-    string serialize() const override {
-        return state_;
-    }
+    /* Returns the state as text: the yellow and the red cells as decimal bitmasks, separated by the player to move (y, r or n). */
+    string serialize() const override;
 
-    static ConnectFourState deserialize(const string &serialized_state) {
-        return ConnectFourState(serialized_state);
-    }
+    /* Reads a state written by serialize(). Throws invalid_argument if it isn't a valid board. */
+    static BasicConnectFourState deserialize(const string &);
 
-    string get() const {
+    BitsType get() const {
         return state_;
     }
 
+    bool operator==(const BasicConnectFourState &rhs) const {
+        return state_ == rhs.state_;
+    }
+
     bool operator==(const GameState &rhs) const override {
-        return state_ == dynamic_cast<const ConnectFourState &>(rhs).state_;
+        return *this == dynamic_cast<const BasicConnectFourState &>(rhs);
     }
 };
 
-template <> struct std::hash<ConnectFourState> : public std::hash<GameState> { using std::hash<GameState>::operator(); };
+template <int N, int M> struct std::hash<BasicConnectFourState<N, M>> : public std::hash<GameState> { using std::hash<GameState>::operator(); };
+
+/* ConnectFour on a board of N rows and M columns. */
+template <int N, int M> class BasicConnectFourGame : public Game<BasicConnectFourState<N, M>, ConnectFourMove> {
+    static_assert(N >= 4 and M >= 4, "ConnectFour needs room for 4 pieces connected");
+    static_assert(CONNECT_FOUR_STATE_BITS<N, M> <= 128, "ConnectFour states are encoded in at most 128 bits");
 
-class ConnectFourGame : public Game<ConnectFourState, ConnectFourMove> {
   private:
-    /* Board is N x M. */
-    static constexpr int N = 6;
-    static constexpr int M = 7;
+    using ConnectFourState = BasicConnectFourState<N, M>;
+    using BaseGame = Game<ConnectFourState, ConnectFourMove>;
+    using BitsType = typename ConnectFourState::BitsType;
 
     /* Cell state constants. */
-    static constexpr int YELLOW = Game<ConnectFourState, ConnectFourMove>::PLAYER_MAX;
-    static constexpr int RED = Game<ConnectFourState, ConnectFourMove>::PLAYER_MIN;
-    static constexpr int NONE = Game<ConnectFourState, ConnectFourMove>::PLAYER_NONE;
+    static constexpr int YELLOW = BaseGame::PLAYER_MAX;
+    static constexpr int RED = BaseGame::PLAYER_MIN;
+    static constexpr int NONE = BaseGame::PLAYER_NONE;
 
-    /* UPRIGHT, RIGHT, DOWNRIGHT, DOWN */
-    static constexpr int DIR[4][2] = {{-1, 1}, {0, 1}, {1, 1}, {1, 0}};
+    /* Every possible win condition (4 cells connected), generated at compile time. */
+    static constexpr auto WINDOWS = get_board_lines<N, M, 4>();
 
     /* Score constants. */
-    static constexpr int UPRIGHT_POSSIBILITIES = 12;
-    static constexpr int RIGHT_POSSIBILITIES = 24;
-    static constexpr int DOWNRIGHT_POSSIBILITIES = 12;
-    static constexpr int DOWN_POSSIBILITIES = 21;
-    static constexpr int TOTAL_POSSIBILITIES = UPRIGHT_POSSIBILITIES + RIGHT_POSSIBILITIES + DOWNRIGHT_POSSIBILITIES + DOWN_POSSIBILITIES;
+    static constexpr int TOTAL_POSSIBILITIES = count_board_lines(N, M, 4);
     static constexpr int MAX_SCORE = 5 * TOTAL_POSSIBILITIES; // Considering every cell is filled with the same color.
 
-    /* Returns if the coordinate is inside the board. */
-    static bool is_inside(int x, int y) {
-        return 0 <= x and x < N and 0 <= y and y < M;
-    }
+    /* Symmetries of the board: identity and the mirror of the columns. Each one undoes itself. */
+    static constexpr int SYMMETRIES = 2;
 
     int board[N][M]; // Board.
 
-    /* Returns the score of the board for the given player. */
-    int get_score_(int) const;
+    /* Counts the possible win conditions (4 cells connected) without enemy pieces, by the number of pieces of the given player in them. */
+    array<int, 5> count_windows_(int) const;
 
     /* Checks if there are 4 pieces connected. */
     bool has_someone_won_() const;
 
+    /* Bits of a column in the state: one per row and one more to mark its height. */
+    static constexpr int COLUMN_BITS = N + 1;
+
+    /* First bit of the player to move in the state, above the columns. */
+    static constexpr int PLAYER_SHIFT = M * COLUMN_BITS;
+
+    /* Returns the given board and player converted to State. Each column stores its pieces from the bottom up (1 for YELLOW, 0 for RED) followed
+       by a 1 above the top piece, and the player to move is stored above the columns (0 for YELLOW, 1 for RED, 2 for NONE). */
+    static ConnectFourState encode_state(const int (&)[N][M], int);
+
+    /* Loads the board of a State and returns its player to move. */
+    static int decode_state(const ConnectFourState &, int (&)[N][M]);
+
+    friend class BasicConnectFourState<N, M>;
+
   protected:
+    using BaseGame::set_player_;
+
     /* Returns the current game state converted to State. */
     ConnectFourState get_state_() const override;
 
@@ -101,16 +140,49 @@ class ConnectFourGame : public Game<ConnectFourState, ConnectFourMove> {
     /* Returns the winner. */
     int get_winner_() const override;
 
+    /* Returns the smallest of the states that are symmetric to the current one, and the symmetry that maps the current state into it. */
+    pair<ConnectFourState, int> get_canonical_state_() const override;
+
+    /* Returns the move mapped by the given symmetry. */
+    ConnectFourMove get_symmetric_move_(const ConnectFourMove &, int) const override;
+
     /* Returns a value between -1 and 1 indicating how probable it is for the first player to win (1.0) or the other player to win (-1.0). */
     double evaluate_() const override;
 
   public:
-    ConnectFourGame();
-    ConnectFourGame(const ConnectFourState &);
+    using BaseGame::get_player;
+    using BaseGame::get_state;
+
+    /* Number of evaluation features. */
+    static constexpr int FEATURES = 3;
+
+    /* Evaluation weights, one per feature. Tuned by tools/tune.cpp. */
+    static Parameter weights[FEATURES];
+
+    /* Returns the name of the board size, which prefixes its parameters: ConnectFour for the standard 6 x 7 board, ConnectFour<N>x<M> otherwise. */
+    static string get_name() {
+        return N == 6 and M == 7 ? "ConnectFour" : "ConnectFour" + to_string(N) + "x" + to_string(M);
+    }
+
+    BasicConnectFourGame();
+    BasicConnectFourGame(const ConnectFourState &);
+
+    /* Returns the evaluation features: for 1, 2 and 3 pieces, the win conditions of YELLOW with that many pieces and no enemy ones, minus those of RED. */
+    array<double, FEATURES> get_features() const;
 
     /* Returns if the move (x, y) is a valid move. */
     bool is_valid_move(const ConnectFourMove &) const override;
 
     /* Returns the board for printing. */
     operator string() const override;
-};
\ No newline at end of file
+};
+
+/* Standard 6 x 7 board. */
+using ConnectFourState = BasicConnectFourState<6, 7>;
+using ConnectFourGame = BasicConnectFourGame<6, 7>;
+
+/* Board sizes compiled in src/ConnectFourGame.cpp. */
+extern template class BasicConnectFourState<6, 7>;
+extern template class BasicConnectFourGame<6, 7>;
+extern template class BasicConnectFourState<7, 8>;
+extern template class BasicConnectFourGame<7, 8>;
@@ -6,6 +6,7 @@
 #include <functional>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 using namespace std;
@@ -86,6 +87,31 @@ template <class StateType, class MoveType> class Game {
         return 0.0;
     }
 
+    /* Returns the smallest of the states that are symmetric to the current one, and the symmetry that maps the current state into it. */
+    virtual pair<StateType, int> get_canonical_state_() const {
+        return {get_state(), 0};
+    }
+
+    /* Returns the move mapped by the given symmetry. */
+    virtual MoveType get_symmetric_move_(const MoveType &m, int) const {
+        return m;
+    }
+
+    /* Returns the symmetry that undoes the given symmetry. */
+    virtual int get_inverse_symmetry_(int symmetry) const {
+        return symmetry;
+    }
+
+    /* Returns true if the move, made in the current state, leaves the opponent few sensible replies (e.g. a capture). Searches extend such moves. */
+    virtual bool is_forcing_move_(const MoveType &) const {
+        return false;
+    }
+
+    /* Returns the moves that change the evaluation sharply (e.g. captures), which searches keep playing past their depth limit. None by default. */
+    virtual vector<MoveType> get_noisy_moves_() const {
+        return {};
+    }
+
     /* ---------- FINAL ---------- */
 
     /* Initializes a new game. This function should be called at the end of initialize_game_() of the derived classes. */
@@ -149,6 +175,21 @@ template <class StateType, class MoveType> class Game {
 
     /* Returns a value between -1 and 1 indicating how probable it is for the first player to win (1.0) or the other player to win (-1.0). */
     virtual double evaluate() const final;
+
+    /* Returns the canonical state shared by all states symmetric to the current one, and the symmetry that maps the current state into it. */
+    virtual pair<StateType, int> get_canonical_state() const final;
+
+    /* Returns the move mapped by the given symmetry. */
+    virtual MoveType get_symmetric_move(const MoveType &, int) const final;
+
+    /* Returns the symmetry that undoes the given symmetry. */
+    virtual int get_inverse_symmetry(int) const final;
+
+    /* Returns true if the move, made in the current state, leaves the opponent few sensible replies (e.g. a capture). */
+    virtual bool is_forcing_move(const MoveType &) const final;
+
+    /* Returns the moves that change the evaluation sharply (e.g. captures). */
+    virtual vector<MoveType> get_noisy_moves() const final;
 };
 
 /* ---------- PROTECTED ---------- */
@@ -272,3 +313,28 @@ template <class StateType, class MoveType> double Game<StateType, MoveType>::eva
 
     return clamp(evaluate_(), nextafter(score_min, score_max), nextafter(score_max, score_min));
 }
+
+/* Returns the canonical state shared by all states symmetric to the current one, and the symmetry that maps the current state into it. */
+template <class StateType, class MoveType> pair<StateType, int> Game<StateType, MoveType>::get_canonical_state() const {
+    return get_canonical_state_();
+}
+
+/* Returns the move mapped by the given symmetry. */
+template <class StateType, class MoveType> MoveType Game<StateType, MoveType>::get_symmetric_move(const MoveType &m, int symmetry) const {
+    return get_symmetric_move_(m, symmetry);
+}
+
+/* Returns the symmetry that undoes the given symmetry. */
+template <class StateType, class MoveType> int Game<StateType, MoveType>::get_inverse_symmetry(int symmetry) const {
+    return get_inverse_symmetry_(symmetry);
+}
+
+/* Returns true if the move, made in the current state, leaves the opponent few sensible replies (e.g. a capture). */
+template <class StateType, class MoveType> bool Game<StateType, MoveType>::is_forcing_move(const MoveType &m) const {
+    return is_forcing_move_(m);
+}
+
+/* Returns the moves that change the evaluation sharply (e.g. captures). */
+template <class StateType, class MoveType> vector<MoveType> Game<StateType, MoveType>::get_noisy_moves() const {
+    return get_noisy_moves_();
+}
@@ -1,17 +1,20 @@
 #pragma once
 
+#include <bitset>
 #include <optional>
 #include <string>
 #include <vector>
 
+#include <Bitboard.hpp>
 #include <Game.hpp>
+#include <Network.hpp>
 
 class KonaneCell {
   public:
     int x, y;
 
-    KonaneCell() : x(-1), y(-1) {}
-    KonaneCell(int x_, int y_) : x(x_), y(y_) {}
+    constexpr KonaneCell() : x(-1), y(-1) {}
+    constexpr KonaneCell(int x_, int y_) : x(x_), y(y_) {}
 
     bool operator==(const KonaneCell &c) const {
         return x == c.x and y == c.y;
@@ -34,6 +37,10 @@ class KonaneMove : public GameMove {
     KonaneMove(KonaneCell ci_, KonaneCell cf_) : ci(ci_), cf(cf_) {}
     KonaneMove(int xi, int yi, int xf, int yf) : KonaneMove(KonaneCell(xi, yi), KonaneCell(xf, yf)) {}
 
+    bool operator==(const KonaneMove &m) const {
+        return ci == m.ci and cf == m.cf;
+    }
+
     operator string() const override {
         if (cf == KonaneCell(-1, -1)) {
             return string(ci);
@@ -43,44 +50,73 @@ class KonaneMove : public GameMove {
     }
 };
 
-class KonaneState : public GameState {
+template <> struct std::hash<KonaneMove> {
+    size_t operator()(const KonaneMove &m) const {
+        return std::hash<int>()(((m.ci.x + 1) * 16 + (m.ci.y + 1)) * 256 + (m.cf.x + 1) * 16 + (m.cf.y + 1));
+    }
+};
+
+/* State of a Konane board of N x M cells: one bit per cell with a pawn, followed by one bit set if WHITE is to move and one if BLACK is. */
+template <int N, int M> class BasicKonaneState : public GameState {
+  public:
+    using BitsType = Bitboard<N * M + 2>;
+
   private:
-    long long state_;
+    BitsType state_;
 
   public:
-    explicit KonaneState(long long state) {
+    explicit BasicKonaneState(BitsType state) {
         state_ = state;
-        hash_ = std::hash<long long>()(state_);
+        hash_ = hash_bits(state_);
     }
 
     string serialize() const override {
-        return to_string(state_);
+        return bits_to_string(state_);
     }
 
-    static KonaneState deserialize(const string &serialized_state) {
-        return KonaneState(stoll(serialized_state));
+    static BasicKonaneState deserialize(const string &serialized_state) {
+        return BasicKonaneState(string_to_bits<BitsType>(serialized_state));
     }
 
-    long long get() const {
+    BitsType get() const {
         return state_;
     }
 
     bool operator==(const GameState &rhs) const override {
-        return state_ == dynamic_cast<const KonaneState &>(rhs).state_;
+        return state_ == dynamic_cast<const BasicKonaneState &>(rhs).state_;
     }
 };
 
-template <> struct std::hash<KonaneState> : public std::hash<GameState> { using std::hash<GameState>::operator(); };
+template <int N, int M> struct std::hash<BasicKonaneState<N, M>> : public std::hash<GameState> { using std::hash<GameState>::operator(); };
+
+/* Konane on a board of N rows and M columns. */
+template <int N, int M> class BasicKonaneGame : public Game<BasicKonaneState<N, M>, KonaneMove> {
+    static_assert(N % 2 == 0 and M % 2 == 0 and N >= 4 and M >= 4, "Konane openings need an even board with a 2 x 2 center");
+    static_assert(N * M + 2 <= 128, "Konane states are encoded in at most 128 bits");
 
-class KonaneGame : public Game<KonaneState, KonaneMove> {
   private:
-    /* Board is N x N. */
-    static constexpr int N = 6;
+    using KonaneState = BasicKonaneState<N, M>;
+    using BaseGame = Game<KonaneState, KonaneMove>;
+    using BoardType = Bitboard<N * M>;
+    using BitsType = typename KonaneState::BitsType;
 
     /* Cell state constants. */
-    static constexpr int WHITE = Game<KonaneState, KonaneMove>::PLAYER_MAX;
-    static constexpr int BLACK = Game<KonaneState, KonaneMove>::PLAYER_MIN;
-    static constexpr int NONE = Game<KonaneState, KonaneMove>::PLAYER_NONE;
+    static constexpr int WHITE = BaseGame::PLAYER_MAX;
+    static constexpr int BLACK = BaseGame::PLAYER_MIN;
+    static constexpr int NONE = BaseGame::PLAYER_NONE;
+
+    /* Board with a pawn on every cell. */
+    static constexpr BoardType FULL_BOARD = N * M == 8 * sizeof(BoardType) ? ~BoardType(0) : (BoardType(1) << (N * M)) - 1;
+
+    /* Cells of the starting moves. WHITE first removes a pawn of its color from the 2 x 2 center or from a corner, and BLACK then removes one of
+       its color next to the empty cell. A cell (x, y) is WHITE's if x + y is odd. */
+    static constexpr bool CENTER_PARITY = (N / 2 + M / 2) % 2;
+    static constexpr KonaneCell WHITE_CENTER[2] = {CENTER_PARITY ? KonaneCell(N / 2 - 1, M / 2 - 1) : KonaneCell(N / 2, M / 2 - 1),
+                                                   CENTER_PARITY ? KonaneCell(N / 2, M / 2) : KonaneCell(N / 2 - 1, M / 2)};
+    static constexpr KonaneCell BLACK_CENTER[2] = {CENTER_PARITY ? KonaneCell(N / 2, M / 2 - 1) : KonaneCell(N / 2 - 1, M / 2 - 1),
+                                                   CENTER_PARITY ? KonaneCell(N / 2 - 1, M / 2) : KonaneCell(N / 2, M / 2)};
+    static constexpr KonaneCell BOTTOM_CORNER = KonaneCell(N - 1, 0);
+    static constexpr KonaneCell TOP_CORNER = KonaneCell(0, M - 1);
 
     /* Direction constants. */
     static constexpr int UP = 0;
@@ -91,20 +127,47 @@ class KonaneGame : public Game<KonaneState, KonaneMove> {
 
     /* Returns if the coordinate is inside the board. */
     static bool is_inside(const KonaneCell &c) {
-        return 0 <= c.x and c.x < N and 0 <= c.y and c.y < N;
+        return 0 <= c.x and c.x < N and 0 <= c.y and c.y < M;
     }
 
     /* From (x, y) to position. */
     static int convert_cell(const KonaneCell &c) {
-        return N * c.x + c.y;
+        return M * c.x + c.y;
     }
 
     /* From position to (x, y). */
     static KonaneCell convert_cell(int p) {
-        return KonaneCell(p / N, p % N);
+        return KonaneCell(p / M, p % M);
+    }
+
+    /* Symmetries of the square that keep the color of every cell: identity, transposition, half turn and anti-transposition. Each one undoes itself.
+       Rectangular boards only have the identity and the half turn (symmetries 0 and 2). */
+    static constexpr int SYMMETRIES = 4;
+    static constexpr int SYMMETRY_STEP = N == M ? 1 : 2;
+
+    /* Returns the cell mapped by the given symmetry. Cells outside the board are kept. */
+    static KonaneCell get_symmetric_cell(KonaneCell c, int symmetry) {
+        if (!is_inside(c)) {
+            return c;
+        }
+
+        if (symmetry & 1) {
+            swap(c.x, c.y);
+        }
+
+        if (symmetry & 2) {
+            c = KonaneCell(N - 1 - c.x, M - 1 - c.y);
+        }
+
+        return c;
     }
 
-    long long board; // Board.
+    /* Inputs of the evaluation network: a pawn on each cell and WHITE to move. The color of a pawn is given by its cell. */
+    static constexpr int NETWORK_INPUTS = N * M + 1;
+
+    BoardType board; // Board.
+
+    typename Network<NETWORK_INPUTS>::AccumulatorStack accumulators; // First layer of the evaluation network along the current line, if it is loaded.
 
     /* Returns the number of pawns remaining on the board. */
     int count_pawns() const;
@@ -133,7 +196,18 @@ class KonaneGame : public Game<KonaneState, KonaneMove> {
     /* Returns all the possible start moves. */
     vector<KonaneMove> get_starting_moves() const;
 
+    /* Returns the given board and the rest of the current game state converted to State. */
+    KonaneState encode_state(BoardType) const;
+
+    /* Returns the inputs of the evaluation network for the current board with the given player to move. */
+    bitset<NETWORK_INPUTS> encode_network_inputs(int) const;
+
+    /* Updates the accumulators of the evaluation network after the board changes, with the given player to move. */
+    void update_accumulators(int);
+
   protected:
+    using BaseGame::set_player_;
+
     /* Returns the current game state converted to State. */
     KonaneState get_state_() const override;
 
@@ -150,18 +224,49 @@ class KonaneGame : public Game<KonaneState, KonaneMove> {
     vector<KonaneMove> get_moves_() const override;
 
     /* Returns the winner. */
-    using Game<KonaneState, KonaneMove>::get_winner_;
+    using BaseGame::get_winner_;
+
+    /* Returns the smallest of the states that are symmetric to the current one, and the symmetry that maps the current state into it. */
+    pair<KonaneState, int> get_canonical_state_() const override;
+
+    /* Returns the move mapped by the given symmetry. */
+    KonaneMove get_symmetric_move_(const KonaneMove &, int) const override;
+
+    /* Returns the multiple jumps. Every move captures in Konane, so single jumps are the quiet ones. */
+    vector<KonaneMove> get_noisy_moves_() const override;
+
+    /* Returns a value between -1 and 1 indicating how probable it is for the first player to win (1.0) or the other player to win (-1.0). */
+    double evaluate_() const override;
 
   public:
-    KonaneGame();
-    KonaneGame(const KonaneState &);
+    using BaseGame::get_enemy;
+    using BaseGame::get_moves;
+    using BaseGame::get_player;
+    using BaseGame::get_state;
+
+    /* Optional evaluation network. Konane has no heuristic evaluation without it. Trained by tools/train.cpp. */
+    static Network<NETWORK_INPUTS> network;
+
+    BasicKonaneGame();
+    BasicKonaneGame(const KonaneState &);
+
+    /* Returns the inputs of the evaluation network. */
+    bitset<NETWORK_INPUTS> get_network_inputs() const;
 
     /* Returns if the move (xi, yi) -> (xf, yf) is a valid move. */
     bool is_valid_move(const KonaneMove &) const override;
 
     /* Returns a value between -1 and 1 indicating how probable it is for the first player to win (1.0) or the other player to win (-1.0). */
-    using Game<KonaneState, KonaneMove>::evaluate;
+    using BaseGame::evaluate;
 
     /* Returns the board for printing. */
     operator string() const override;
-};
\ No newline at end of file
+};
+
+/* Standard 6 x 6 board. */
+using KonaneState = BasicKonaneState<6, 6>;
+using KonaneGame = BasicKonaneGame<6, 6>;
+
+/* Board sizes compiled in src/KonaneGame.cpp. */
+extern template class BasicKonaneGame<6, 6>;
+extern template class BasicKonaneGame<8, 8>;
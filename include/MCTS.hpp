@@ -0,0 +1,418 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <Game.hpp>
+#include <Minimax.hpp>
+
+using namespace std;
+
+/* Monte Carlo Tree Search for games derived from Game class. */
+template <class GameType> class MCTS {
+  public:
+    using StateType = typename GameType::state_type;
+    using MoveType = typename GameType::move_type;
+    using OptimalMove = typename Minimax<GameType>::OptimalMove;
+
+    class Limits {
+      public:
+        optional<chrono::duration<long double>> timeout = nullopt; // Time limit.
+        optional<long long> playouts = nullopt;                    // Playout limit.
+    };
+
+    class Settings {
+      public:
+        double exploration = sqrt(2.0); // UCT exploration constant.
+        int threads = 1;                // Number of threads searching the same tree.
+        int virtual_loss = 3;           // Losses temporarily added to a node while a thread is searching below it.
+        int max_nodes = 1 << 19;        // Size of the node pool.
+        int max_playout_length = 200;   // Playouts longer than this are scored with Game::evaluate, since games may have cycles.
+        bool persistent = true;         // Reuse the subtree of the new root between get_move calls.
+    };
+
+  private:
+    /* Node expansion constants. */
+    static constexpr int UNEXPANDED = 0;
+    static constexpr int EXPANDING = 1;
+    static constexpr int EXPANDED = 2;
+
+    /* A win for the player who moved into a node is worth SCORE_SCALE. A draw is worth half of it. */
+    static constexpr long long SCORE_SCALE = 1 << 16;
+
+    /* Number of playouts between two deadline checks. */
+    static constexpr int DEADLINE_CHECK_INTERVAL = 64;
+
+    class Node {
+      public:
+        MoveType move;                      // Move that leads to this node.
+        int player = GameType::PLAYER_NONE; // Player who made the move.
+        int first_child = -1;               // Index of the first child in the node pool. Children are contiguous.
+        int child_count = 0;                // Number of children. Valid once the node is EXPANDED.
+        atomic<int> state = UNEXPANDED;     // UNEXPANDED, EXPANDING or EXPANDED.
+        atomic<int> visits = 0;             // Visits, including virtual losses of threads currently below this node.
+        atomic<long long> score = 0;        // Sum of the results for the player who made the move.
+    };
+
+    Settings settings;                         // Settings.
+    unique_ptr<Node[]> pool;                   // Node pool. The root is always node 0.
+    unique_ptr<Node[]> spare_pool;             // Pool into which the kept subtree is compacted, swapped with the node pool.
+    atomic<int> pool_size = 0;                 // Number of nodes allocated from the pool.
+    optional<StateType> root_state = nullopt;  // State of the root of the tree.
+    int root_turn = 0;                         // Turn of the root of the tree.
+    atomic<bool> stopped = false;              // Set when the limits are reached.
+    atomic<long long> playouts = 0;            // Playouts of the current get_move call.
+    atomic<int> max_depth = 0;                 // Deepest node selected in the current get_move call.
+
+    /* Allocates count contiguous nodes from the pool. Returns -1 if the pool is full. */
+    int allocate(int count) {
+        int index = pool_size.load();
+
+        do {
+            if (index + count > settings.max_nodes) {
+                return -1;
+            }
+        } while (!pool_size.compare_exchange_weak(index, index + count));
+
+        return index;
+    }
+
+    /* Resets the tree to a single root node. */
+    void reset_tree(const GameType &game) {
+        if (pool == nullptr) {
+            pool = make_unique<Node[]>(settings.max_nodes);
+        }
+
+        pool_size = 0;
+        copy_node(pool[allocate(1)], Node());
+        pool[0].player = game.get_enemy();
+    }
+
+    /* Copies the search data of a node. The source must not be searched concurrently. */
+    static void copy_node(Node &to, const Node &from) {
+        to.move = from.move;
+        to.player = from.player;
+        to.first_child = -1;
+        to.child_count = 0;
+        to.state = from.state == EXPANDED ? EXPANDED : UNEXPANDED;
+        to.visits = from.visits.load();
+        to.score = from.score.load();
+    }
+
+    /* Makes node the new root of the tree, compacting its subtree into the spare pool, which then becomes the node pool. Both pools are allocated
+       once, and every node is initialized when it is allocated, so the nodes left in the old pool need no clearing. */
+    void compact_tree(int node) {
+        if (spare_pool == nullptr) {
+            spare_pool = make_unique<Node[]>(settings.max_nodes);
+        }
+
+        swap(pool, spare_pool);
+        const unique_ptr<Node[]> &old_pool = spare_pool;
+        pool_size = 0;
+
+        vector<pair<int, int>> queue = {{node, allocate(1)}}; // (old index, new index)
+        copy_node(pool[0], old_pool[node]);
+
+        for (int i = 0; i < queue.size(); i++) {
+            auto [old_index, new_index] = queue[i];
+            const Node &old_node = old_pool[old_index];
+
+            if (old_node.state != EXPANDED) {
+                continue;
+            }
+
+            int first_child = allocate(old_node.child_count);
+            pool[new_index].first_child = first_child;
+            pool[new_index].child_count = old_node.child_count;
+
+            for (int j = 0; j < old_node.child_count; j++) {
+                copy_node(pool[first_child + j], old_pool[old_node.first_child + j]);
+                queue.push_back({old_node.first_child + j, first_child + j});
+            }
+        }
+    }
+
+    /* Keeps the subtree of the current state of the game if the tree contains it. Resets the tree otherwise. */
+    void reuse_tree(const GameType &game_) {
+        const vector<StateType> &states = game_.get_states();
+
+        if (!settings.persistent or !root_state.has_value() or game_.get_turn() < root_turn or !(states[root_turn - 1] == root_state.value())) {
+            reset_tree(game_);
+            return;
+        }
+
+        // Following the moves played since the last search.
+        GameType replay(root_state.value());
+        int node = 0;
+
+        for (int turn = root_turn; turn < game_.get_turn(); turn++) {
+            int next_node = -1;
+
+            for (int i = 0; pool[node].state == EXPANDED and i < pool[node].child_count and next_node == -1; i++) {
+                replay.make_move(pool[pool[node].first_child + i].move);
+
+                if (replay.get_state() == states[turn]) {
+                    next_node = pool[node].first_child + i;
+                } else {
+                    replay.rollback();
+                }
+            }
+
+            if (next_node == -1) {
+                reset_tree(game_);
+                return;
+            }
+
+            node = next_node;
+        }
+
+        compact_tree(node);
+    }
+
+    /* Expands the node. Returns false if another thread is expanding it or if the pool is full. */
+    bool expand(Node &node, const GameType &game) {
+        int expected = UNEXPANDED;
+
+        if (!node.state.compare_exchange_strong(expected, EXPANDING)) {
+            return false;
+        }
+
+        const vector<MoveType> &moves = game.get_moves();
+        int first_child = allocate(moves.size());
+
+        if (first_child == -1) {
+            node.state = UNEXPANDED;
+            return false;
+        }
+
+        for (int i = 0; i < moves.size(); i++) {
+            copy_node(pool[first_child + i], Node());
+            pool[first_child + i].move = moves[i];
+            pool[first_child + i].player = game.get_player();
+        }
+
+        node.first_child = first_child;
+        node.child_count = moves.size();
+        node.state = EXPANDED;
+        return true;
+    }
+
+    /* Returns the index of the child with the highest upper confidence bound. */
+    int select_child(const Node &node) const {
+        double log_visits = log(max(1, node.visits.load()));
+        double best_value = -numeric_limits<double>::infinity();
+        int best_child = node.first_child;
+
+        for (int i = node.first_child; i < node.first_child + node.child_count; i++) {
+            int visits = pool[i].visits;
+
+            if (visits == 0) { // Unvisited children first.
+                return i;
+            }
+
+            double value = pool[i].score / static_cast<double>(SCORE_SCALE * visits) + settings.exploration * sqrt(log_visits / visits);
+
+            if (value > best_value) {
+                best_value = value;
+                best_child = i;
+            }
+        }
+
+        return best_child;
+    }
+
+    /* Plays random moves until the game ends. Returns the score of PLAYER_MAX. */
+    long long playout(GameType &game, mt19937 &rng) const {
+        int length = 0;
+
+        while (!game.is_game_over() and length < settings.max_playout_length) {
+            const vector<MoveType> &moves = game.get_moves();
+            game.make_move(MoveType(moves[rng() % moves.size()]));
+            length++;
+        }
+
+        long long score;
+
+        if (game.is_game_over()) {
+            score = SCORE_SCALE / 2 * (1 + game.get_winner().value());
+        } else {
+            score = llround(SCORE_SCALE / 2 * (1.0 + game.evaluate()));
+        }
+
+        while (length--) {
+            game.rollback();
+        }
+
+        return score;
+    }
+
+    /* Runs playouts from the root until the search is stopped. */
+    void search(GameType game, unsigned int seed, const Limits &limits, chrono::time_point<chrono::high_resolution_clock> deadline) {
+        mt19937 rng(seed);
+        vector<int> path;
+
+        for (long long i = 1; !stopped; i++) {
+            // Selection, with virtual losses so that other threads prefer other paths.
+            path.assign(1, 0);
+            pool[0].visits++;
+
+            while (pool[path.back()].state == EXPANDED and pool[path.back()].child_count > 0) {
+                int child = select_child(pool[path.back()]);
+                pool[child].visits += settings.virtual_loss;
+                game.make_move(pool[child].move);
+                path.push_back(child);
+            }
+
+            // Expansion of nodes which were already visited.
+            Node &leaf = pool[path.back()];
+
+            if (!game.is_game_over() and (path.size() == 1 or leaf.visits > settings.virtual_loss) and expand(leaf, game)) {
+                int child = select_child(leaf);
+                pool[child].visits += settings.virtual_loss;
+                game.make_move(pool[child].move);
+                path.push_back(child);
+            }
+
+            // Simulation.
+            long long score = playout(game, rng);
+
+            // Backpropagation, removing the virtual losses.
+            for (int j = path.size() - 1; j >= 0; j--) {
+                Node &node = pool[path[j]];
+
+                if (j > 0) {
+                    node.visits += 1 - settings.virtual_loss;
+                    game.rollback();
+                }
+
+                node.score += node.player == GameType::PLAYER_MAX ? score : SCORE_SCALE - score;
+            }
+
+            // Checking limits.
+            int depth = path.size() - 1;
+            int current_max_depth = max_depth;
+
+            while (depth > current_max_depth and !max_depth.compare_exchange_weak(current_max_depth, depth)) {
+            }
+
+            if (limits.playouts.has_value() and ++playouts >= limits.playouts.value()) {
+                stopped = true;
+            }
+
+            if (!limits.playouts.has_value()) {
+                playouts++;
+            }
+
+            if (i % DEADLINE_CHECK_INTERVAL == 0 and chrono::high_resolution_clock::now() > deadline) {
+                stopped = true;
+            }
+        }
+    }
+
+  public:
+    MCTS() = default;
+    MCTS(const Settings &settings_) : settings(settings_) {}
+    ~MCTS() = default;
+
+    /* Returns the number of playouts of the last get_move call. */
+    long long get_playouts() const {
+        return playouts;
+    }
+
+    /* Forgets the tree. */
+    void clear() {
+        root_state = nullopt;
+    }
+
+    /* Returns the most visited move given a time limit. */
+    pair<OptimalMove, int> get_move(const GameType &game_, chrono::duration<long double> timeout) {
+        Limits limits;
+        limits.timeout = timeout;
+        return get_move(game_, limits);
+    }
+
+    /* Returns the most visited move within the given limits, which need a timeout or a playout limit. The second element is the depth of the deepest
+       selected node. */
+    pair<OptimalMove, int> get_move(const GameType &game_, const Limits &limits) {
+#ifdef DEBUG
+        assert(limits.timeout.has_value() or limits.playouts.has_value()); // An unlimited search would never end.
+#endif
+
+        // A finished game has no move to choose.
+        if (game_.is_game_over()) {
+            int winner = game_.get_winner().value();
+            return {OptimalMove(MoveType(), Minimax<GameType>::terminal_score(winner, game_.get_turn()), winner, game_.get_turn()), 0};
+        }
+
+        chrono::time_point<chrono::high_resolution_clock> deadline = chrono::time_point<chrono::high_resolution_clock>::max();
+
+        if (limits.timeout.has_value()) {
+            deadline = chrono::high_resolution_clock::now() + chrono::duration_cast<chrono::high_resolution_clock::duration>(limits.timeout.value());
+        }
+
+        // Initializing.
+        reuse_tree(game_);
+        root_state = game_.get_state();
+        root_turn = game_.get_turn();
+        stopped = !limits.timeout.has_value() and !limits.playouts.has_value();
+        playouts = 0;
+        max_depth = 0;
+
+        // Tree-parallel search.
+        vector<thread> threads;
+
+        for (int i = 1; i < settings.threads; i++) {
+            threads.emplace_back(&MCTS::search, this, game_, random_device()(), cref(limits), deadline);
+        }
+
+        search(game_, random_device()(), limits, deadline);
+
+        for (thread &t : threads) {
+            t.join();
+        }
+
+        // Answering with the first move if the root was never expanded, as without limits or with a full node pool.
+        const Node &root = pool[0];
+
+        if (root.state != EXPANDED or root.child_count == 0) {
+            return {OptimalMove(game_.get_moves()[0], Minimax<GameType>::evaluation_score(game_.evaluate()), nullopt, game_.get_turn() + 1), 0};
+        }
+
+        // Most visited move.
+        int best_child = root.first_child;
+
+        for (int i = root.first_child; i < root.first_child + root.child_count; i++) {
+            if (pool[i].visits > pool[best_child].visits) {
+                best_child = i;
+            }
+        }
+
+        OptimalMove ans;
+        ans.move = pool[best_child].move;
+        ans.turn = game_.get_turn() + 1;
+
+        // Score of PLAYER_MAX, scaled like the Minimax evaluations.
+        double win_rate = pool[best_child].score / static_cast<double>(SCORE_SCALE * max(1, pool[best_child].visits.load()));
+        ans.score = Minimax<GameType>::evaluation_score((2.0 * win_rate - 1.0) * (pool[best_child].player == GameType::PLAYER_MAX ? 1.0 : -1.0));
+
+        // Only immediate wins are known to be optimal.
+        GameType game = game_;
+        game.make_move(ans.move);
+
+        if (game.is_game_over()) {
+            ans.winner = game.get_winner();
+            ans.score = Minimax<GameType>::terminal_score(game.get_winner().value(), game.get_turn());
+        }
+
+        return {ans, max_depth};
+    }
+};
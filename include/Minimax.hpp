@@ -1,15 +1,31 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
+#include <future>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
+#include <tuple>
+#include <typeinfo>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include <Game.hpp>
+#include <OpeningBook.hpp>
+#include <SearchPosition.hpp>
+#include <SearchStatistics.hpp>
+#include <TranspositionTable.hpp>
 
 using namespace std;
 
@@ -22,120 +38,645 @@ template <class GameType> class Minimax {
     class OptimalMove {
       public:
         MoveType move = MoveType();     // The move itself
-        double score = 0.0;             // [-1, +1]
+        int score = 0;                  // Fixed-point evaluation, or a win/loss score that encodes the turn in which the game ends. See Minimax::terminal_score.
         optional<int> winner = nullopt; // Is it solved? Who wins? Max, Min or Draw?
         int turn = -1;                  // In which turn this move ends, relative to the start of the game.
         bool pruned = false;     // True if the other moves were not considered due to pruning, implying that the results in this OptimalMove are unreliable.
-        bool hits_cycle = false; // (CURRENTLY UNUSED) True if movement can end up hitting a previously seen game state.
+        bool hits_cycle = false; // True if the line of the move reaches a state of the search again. Not kept in the transposition table.
 
         OptimalMove() {}
 
-        OptimalMove(const MoveType &move_, double score_, optional<int> winner_, int turn_) {
+        OptimalMove(const MoveType &move_, int score_, optional<int> winner_, int turn_) {
             move = move_;
             score = score_;
             winner = winner_;
             turn = turn_;
         }
+
+        /* Returns the score in [-1, +1], as returned by Game::evaluate. */
+        double evaluation() const {
+            if (is_decisive(score)) {
+                return score > 0 ? 1.0 : -1.0;
+            }
+
+            return static_cast<double>(score) / MAX_EVALUATION;
+        }
+    };
+
+    /* Score constants. Evaluations are scaled to (-MAX_EVALUATION, +MAX_EVALUATION), won games score beyond that. */
+    static constexpr int MAX_EVALUATION = 1000000;    // Score of Game::evaluate() returning 1.0.
+    static constexpr int WIN_SCORE = 1000000000;      // Score of PLAYER_MAX winning in turn 0. Every turn that the game lasts costs 1.
+    static constexpr int INFINITE_SCORE = WIN_SCORE + 1; // Worse than any loss.
+
+    /* Returns the score of a result of Game::evaluate. */
+    static int evaluation_score(double evaluation) {
+        return clamp(static_cast<int>(lround(evaluation * MAX_EVALUATION)), 1 - MAX_EVALUATION, MAX_EVALUATION - 1);
+    }
+
+    /* Returns the score of a game that ends in the given turn. Shorter wins and longer losses score better. */
+    static int terminal_score(int winner, int turn) {
+        return winner * (WIN_SCORE - turn);
+    }
+
+    /* Returns true if the score is a win or a loss. */
+    static bool is_decisive(int score) {
+        return abs(score) >= MAX_EVALUATION;
+    }
+
+    class Limits {
+      public:
+        optional<chrono::duration<long double>> timeout = nullopt; // Time limit. Depths are searched while they are expected to fit in it.
+        optional<int> depth = nullopt;                             // Depth limit.
+        optional<long long> nodes = nullopt;                       // Node limit.
+        const atomic<bool> *stop = nullptr;                        // Searching stops as soon as it becomes true. Owned by the caller.
+    };
+
+    /* Root move with its exact score and expected line, found by the multi-PV searches. */
+    class Line {
+      public:
+        OptimalMove ans;                      // Root move and its score.
+        vector<MoveType> principal_variation; // Expected line, starting with the root move.
+    };
+
+    /* Result of an iteration of iterative deepening, reported while searching. */
+    class Progress {
+      public:
+        int depth = 0;                        // Depth searched.
+        OptimalMove ans;                      // Best move at this depth.
+        vector<MoveType> principal_variation; // Expected line, starting with the best move.
+        long long nodes = 0;                  // Nodes searched so far by this get_move call.
+        double time = 0.0;                    // Seconds spent so far by this get_move call.
+        vector<Line> lines;                   // Best root moves at this depth if Settings::multi_pv > 1, best first.
+    };
+
+    class Settings {
+      public:
+        bool persistent = true;                        // Keep the transposition table, history tables and principal variation between get_move calls.
+        size_t transposition_table_megabytes = 16;     // Size of the transposition table.
+        bool huge_pages = false;                       // Back the transposition table with huge pages, if the system provides them.
+        string transposition_table_path = "";          // File the transposition table is mapped to, which keeps it between runs. Linux only.
+        bool transposition_table_read_only = false;    // Load the transposition table file without writing to it.
+        bool symmetries = true;                        // Share transposition table entries between symmetric states.
+        bool late_move_reductions = false;             // Search late moves shallower, and again at full depth if they raise the bound.
+        int full_depth_moves = 3;                      // Moves searched at full depth before late move reductions start.
+        int reduction_min_height = 3;                  // Smallest height at which late moves are reduced.
+        int reduction = 1;                             // Plies by which late moves are reduced. At least one ply is always searched.
+        bool single_reply_extensions = false;          // Search the only move of a state one ply deeper.
+        bool forcing_move_extensions = false;          // Search moves for which Game::is_forcing_move is true one ply deeper.
+        int max_extensions = 2;                        // Most plies by which extensions can deepen a line, net of reductions.
+        bool quiescence = true;                        // Keep playing Game::get_noisy_moves past the depth limit until the state is quiet.
+        int max_quiescence_depth = 8;                  // Most noisy moves played past the depth limit.
+        bool opening_book = true;                      // Play the moves of Minimax::book without searching.
+        int multi_pv = 1;                              // Root moves found with exact scores at every depth. Each one after the first costs a search.
     };
 
+    /* Search started by Minimax::start_search, running on its own thread. Destroying it stops the search and waits for it to end. */
+    class AsyncSearch {
+      private:
+        /* State shared with the search thread. */
+        class SharedState {
+          public:
+            atomic<bool> stop = false;   // Stops the search.
+            mutex progress_mutex;        // Guards progress.
+            optional<Progress> progress; // Result of the last finished depth.
+        };
+
+        shared_ptr<SharedState> state;
+        shared_future<tuple<OptimalMove, int, SearchStatistics>> result;
+
+        friend class Minimax;
+
+      public:
+        AsyncSearch() = default;
+        AsyncSearch(AsyncSearch &&) = default;
+
+        AsyncSearch &operator=(AsyncSearch &&other) {
+            stop();
+            state = move(other.state);
+            result = move(other.result);
+            return *this;
+        }
+
+        ~AsyncSearch() {
+            stop();
+        }
+
+        /* Returns the result of the last finished depth, or nullopt if no depth finished yet. */
+        optional<Progress> get_progress() const {
+            if (state == nullptr) {
+                return nullopt;
+            }
+
+            lock_guard<mutex> lock(state->progress_mutex);
+            return state->progress;
+        }
+
+        /* Returns true if the search ended. */
+        bool is_done() const {
+            return !result.valid() or result.wait_for(0s) == future_status::ready;
+        }
+
+        /* Stops the search and waits for it to end, which takes about one Minimax::solve call. The result keeps the last finished depth. */
+        void stop() {
+            if (state != nullptr) {
+                state->stop = true;
+            }
+
+            if (result.valid()) {
+                result.wait();
+            }
+        }
+
+        /* Returns the future result of the search, as returned by Minimax::get_move. */
+        shared_future<tuple<OptimalMove, int, SearchStatistics>> get_future() const {
+            return result;
+        }
+    };
+
+    /* Opening book shared by every Minimax of the game. Empty until loaded. */
+    inline static OpeningBook<GameType> book;
+
   private:
-    GameType game;                                               // Game.
+    /* Transposition table bound constants. */
+    static constexpr int EXACT = 0;
+    static constexpr int LOWER_BOUND = 1;
+    static constexpr int UPPER_BOUND = 2;
+
+    /* Number of Minimax::solve calls between two deadline checks. */
+    static constexpr int DEADLINE_CHECK_INTERVAL = 1024;
+
+    /* Value of TranspositionTable::Entry::winner when the state is not solved. */
+    static constexpr int8_t UNSOLVED = -2;
+
+    /* Returns the result stored in a transposition table entry, converted back to the given turn. Win/loss scores are stored relative to the turn of
+       the state. */
+    static OptimalMove get_entry_result(const TranspositionTable::Entry &entry, const MoveType &move, int turn_) {
+        OptimalMove ans(move, entry.score, nullopt, entry.turn + turn_);
+        ans.pruned = entry.pruned;
+
+        if (entry.winner != UNSOLVED) {
+            ans.winner = entry.winner;
+        }
+
+        if (is_decisive(entry.score)) {
+            ans.score += entry.score > 0 ? -turn_ : turn_;
+        }
+
+        return ans;
+    }
+
+    /* Returns the transposition table entry of the result of the search of a state in the given turn, without its move. */
+    static TranspositionTable::Entry make_entry(const OptimalMove &ans, int turn_) {
+        TranspositionTable::Entry entry;
+        entry.score = ans.score;
+        entry.turn = ans.turn - turn_;
+        entry.winner = ans.winner.has_value() ? ans.winner.value() : UNSOLVED;
+        entry.pruned = ans.pruned;
+
+        if (is_decisive(entry.score)) {
+            entry.score += entry.score > 0 ? turn_ : -turn_;
+        }
+
+        return entry;
+    }
+
+    /* Returns the hash of a move stored in the transposition table. */
+    static uint32_t get_move_hash(const MoveType &move) {
+        return static_cast<uint32_t>(std::hash<MoveType>()(move));
+    }
+
+    SearchPosition<GameType> position;                           // Position being searched.
+    Settings settings;                                           // Search settings.
     long long previous_depths_move_count, next_depth_move_count; // Used for estimating the time cost of Minimax::solve
+    chrono::time_point<chrono::high_resolution_clock> deadline;  // Time at which an unfinished Minimax::solve call is abandoned.
+    long long nodes = 0;                                         // Minimax::solve calls of the current get_move call.
+    int iteration_depth = 0;                                     // Depth of the current iteration of iterative deepening.
+    SearchStatistics statistics;                                 // Statistics of the current get_move call.
+    long long node_limit = 0;                                    // Nodes after which an unfinished Minimax::solve call is abandoned.
+    const atomic<bool> *stop = nullptr;                          // Abandons the current Minimax::solve call when it becomes true.
+    bool abandoned = false;                                      // True if the current Minimax::solve call went past a limit or was stopped.
+    vector<MoveType> excluded_moves;                             // Root moves skipped by Minimax::solve, already found by multi-PV searches.
+
+    shared_ptr<TranspositionTable> transposition_table;               // Results of previous searches.
+    bool shared_transposition_table = false;                          // True if other Minimax use the table too, so that it is never cleared.
+    unordered_map<MoveType, long long> history[2];                    // History heuristic scores for PLAYER_MAX and PLAYER_MIN.
+    vector<MoveType> principal_variation;                             // Principal variation of the last search.
+    vector<Line> lines;                                               // Best root moves of the last search, if Settings::multi_pv > 1.
+    optional<StateType> principal_variation_root;                     // State in which the principal variation starts.
+    int principal_variation_turn = 0;                                 // Turn in which the principal variation starts.
+    uint8_t generation = 0;                                           // Transposition table generation of the current get_move call.
+
+    /* Returns the index of the player in the history tables. */
+    static int get_player_index(int player) {
+        return player == GameType::PLAYER_MAX ? 0 : 1;
+    }
+
+    /* Returns the transposition table key of the current state and the symmetry that maps the state into it. */
+    pair<StateType, int> get_key() const {
+        return settings.symmetries ? position.get_canonical_state() : make_pair(position.get_state(), 0);
+    }
+
+    /* Returns the move of an entry: the move of the current state that the symmetry of the key maps to the stored one, if any. */
+    optional<MoveType> get_entry_move(const TranspositionTable::Entry &entry, int symmetry) const {
+        for (const MoveType &move : position.get_moves()) {
+            if (get_move_hash(symmetry == 0 ? move : position.get_symmetric_move(move, symmetry)) == entry.move) {
+                return move;
+            }
+        }
+
+        return nullopt;
+    }
+
+    /* Returns the transposition table entry for the key, if any. */
+    optional<TranspositionTable::Entry> probe(const StateType &key) const {
+        return transposition_table->probe(key.hash());
+    }
+
+    /* Same as probe, but counted. Used by the search itself. */
+    optional<TranspositionTable::Entry> counted_probe(const StateType &key) {
+        optional<TranspositionTable::Entry> entry = probe(key);
+        statistics.add_probe(entry.has_value());
+        return entry;
+    }
+
+    /* Stores the result of a search of the current state. Prefers deeper searches within the same get_move call. */
+    void store(const pair<StateType, int> &key, const OptimalMove &ans, int height, int bound) {
+        TranspositionTable::Entry entry = make_entry(ans, position.get_turn());
+        entry.move = get_move_hash(position.get_symmetric_move(ans.move, key.second));
+        entry.height = height;
+        entry.bound = bound;
+        entry.generation = generation;
+        transposition_table->store(key.first.hash(), entry);
+    }
+
+    /* Returns the moves sorted by the transposition table move first and then by history score. */
+    vector<MoveType> order_moves(const vector<MoveType> &moves, const optional<MoveType> &hint) const {
+        const unordered_map<MoveType, long long> &player_history = history[get_player_index(position.get_player())];
+        vector<pair<long long, int>> keys(moves.size());
+
+        for (int i = 0; i < moves.size(); i++) {
+            auto it = player_history.find(moves[i]);
+            keys[i] = {it == player_history.end() ? 0 : it->second, i};
+
+            if (hint.has_value() and moves[i] == hint.value()) {
+                keys[i].first = numeric_limits<long long>::max();
+            }
+        }
+
+        sort(keys.begin(), keys.end(), [](const pair<long long, int> &a, const pair<long long, int> &b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+
+        vector<MoveType> ordered_moves;
+        ordered_moves.reserve(moves.size());
+
+        for (const pair<long long, int> &key : keys) {
+            ordered_moves.push_back(moves[key.second]);
+        }
+
+        return ordered_moves;
+    }
+
+    /* Clears the transposition table, unless it is shared or kept in a file, history tables and principal variation. */
+    void clear_search_state() {
+        if (!shared_transposition_table and !transposition_table->is_file_backed()) {
+            transposition_table->clear();
+        }
+
+        history[0].clear();
+        history[1].clear();
+        principal_variation.clear();
+        principal_variation_root = nullopt;
+    }
+
+    /* Ages the search state kept from previous get_move calls. The transposition table ages its entries by generation. */
+    void age_search_state() {
+        // Halving the history scores so that recent searches weigh more.
+        for (unordered_map<MoveType, long long> &player_history : history) {
+            for (auto it = player_history.begin(); it != player_history.end();) {
+                it->second /= 2;
+                it = it->second == 0 ? player_history.erase(it) : next(it);
+            }
+        }
+    }
+
+    /* Drops the moves that were played since the last search from the principal variation, or clears it if the game did not follow it. */
+    void advance_principal_variation(const GameType &game_) {
+        const vector<StateType> &states = game_.get_states();
+        int played = game_.get_turn() - principal_variation_turn;
+
+        if (!principal_variation_root.has_value() or played < 0 or played > principal_variation.size() or
+            !(states[principal_variation_turn - 1] == principal_variation_root.value())) {
+            principal_variation.clear();
+            return;
+        }
+
+        GameType replay(principal_variation_root.value());
+
+        for (int i = 0; i < played; i++) {
+            if (!replay.is_valid_move(principal_variation[i])) {
+                principal_variation.clear();
+                return;
+            }
+
+            replay.make_move(principal_variation[i]);
+        }
+
+        if (!(replay.get_state() == game_.get_state())) {
+            principal_variation.clear();
+            return;
+        }
+
+        principal_variation.erase(principal_variation.begin(), principal_variation.begin() + played);
+    }
+
+    /* Stores the principal variation as move ordering hints where the transposition table has no entry. */
+    void seed_principal_variation() {
+        int made = 0;
+
+        for (const MoveType &move : principal_variation) {
+            if (position.is_game_over() or !position.is_valid_move(move)) {
+                break;
+            }
+
+            pair<StateType, int> key = get_key();
+
+            if (!probe(key.first).has_value()) {
+                TranspositionTable::Entry entry;
+                entry.move = get_move_hash(position.get_symmetric_move(move, key.second));
+                entry.winner = UNSOLVED;
+                entry.generation = generation;
+                transposition_table->store(key.first.hash(), entry);
+            }
 
-    /* Returns true if A is a better move than B for PLAYER_MAX. */
-    bool better_max(const OptimalMove &a, const OptimalMove &b) {
-        if (a.score != b.score) { // Take best score.
-            return a.score > b.score;
+            position.make_move(move);
+            made++;
         }
 
-        if (a.pruned != b.pruned) { // Prioritize reliable moves.
-            return a.pruned < b.pruned;
+        while (made--) {
+            position.rollback();
         }
+    }
+
+    /* Returns the line of at most max_length moves that follows the transposition table moves from the current state. */
+    vector<MoveType> get_table_line(int max_length) {
+        unordered_set<StateType> visited;
+        vector<MoveType> line;
+
+        while (line.size() < max_length and !position.is_game_over() and visited.insert(position.get_state()).second) {
+            pair<StateType, int> key = get_key();
+            optional<TranspositionTable::Entry> entry = probe(key.first);
+            optional<MoveType> move = entry.has_value() ? get_entry_move(entry.value(), key.second) : nullopt;
+
+            if (!move.has_value()) {
+                break;
+            }
 
-        if (a.score == static_cast<double>(GameType::PLAYER_MAX)) { // Already won, so take the shortest path.
-            return a.turn < b.turn;
+            line.push_back(move.value());
+            position.make_move(line.back());
         }
 
-        if (a.score == static_cast<double>(GameType::PLAYER_MIN)) { // Already lost, so take the longest path.
-            return a.turn > b.turn;
+        for (int i = 0; i < line.size(); i++) {
+            position.rollback();
         }
 
-        if (a.score >= static_cast<double>(GameType::PLAYER_NONE)) { // Not losing, so prefer solved.
-            return a.winner.has_value() > b.winner.has_value();
+        return line;
+    }
+
+    /* Finds the best root moves after the given one, searching the root again without the moves already found. A root move can't score better than
+       the one found before it, so each search only needs a window up to that score, and is searched again with a full window if the score falls
+       outside it anyway. Returns the lines found, best first, stopping early if the search is abandoned. */
+    vector<Line> search_lines(const OptimalMove &best, int depth) {
+        vector<Line> lines_ = {{best, get_table_line(depth + 1)}};
+        const int player = position.get_player(), move_count = position.get_moves().size();
+
+        while (lines_.size() < min(settings.multi_pv, move_count)) {
+            const int score = lines_.back().ans.score;
+            excluded_moves.push_back(lines_.back().ans.move);
+            OptimalMove ans = solve(player == GameType::PLAYER_MIN ? score - 1 : -INFINITE_SCORE, player == GameType::PLAYER_MAX ? score + 1 : INFINITE_SCORE,
+                                    depth, 0);
+
+            if (!abandoned and (player == GameType::PLAYER_MAX ? ans.score > score : ans.score < score)) {
+                ans = solve(-INFINITE_SCORE, INFINITE_SCORE, depth, 0);
+            }
+
+            if (abandoned) {
+                break;
+            }
+
+            position.make_move(ans.move);
+            vector<MoveType> line = get_table_line(depth);
+            position.rollback();
+
+            line.insert(line.begin(), ans.move);
+            lines_.push_back({ans, line});
         }
 
-        // Losing, so prefer unsolved.
-        return a.winner.has_value() < b.winner.has_value();
+        excluded_moves.clear();
+        return lines_;
     }
 
-    /* Returns true if A is a better move than B for PLAYER_MIN. */
-    bool better_min(const OptimalMove &a, const OptimalMove &b) {
-        if (a.score != b.score) { // Take best score.
-            return a.score < b.score;
+    /* Returns how many plies deeper than usual the move is searched. A line that was already extended by Settings::max_extensions is not extended,
+       so that games with long forced sequences don't search forever. */
+    int get_extension(const vector<MoveType> &moves, const MoveType &move, int height, int ply) const {
+        if (ply + height - iteration_depth >= settings.max_extensions) {
+            return 0;
         }
 
-        if (a.pruned != b.pruned) { // Prioritize reliable moves.
-            return a.pruned < b.pruned;
+        if (settings.single_reply_extensions and moves.size() == 1) {
+            return 1;
         }
 
-        if (a.score == static_cast<double>(GameType::PLAYER_MIN)) { // Already won, so take the shortest path.
-            return a.turn < b.turn;
+        return settings.forcing_move_extensions and position.is_forcing_move(move) ? 1 : 0;
+    }
+
+    /* Returns how many plies shallower than usual the i-th move is searched. Only quiet moves after the first few are reduced, by Settings::reduction
+       plies, but never to less than one ply. */
+    int get_reduction(const MoveType &move, int i, int height, int extension) const {
+        if (!settings.late_move_reductions or i < settings.full_depth_moves or height < settings.reduction_min_height or extension != 0 or
+            position.is_forcing_move(move)) {
+            return 0;
         }
 
-        if (a.score == static_cast<double>(GameType::PLAYER_MAX)) { // Already lost, so take the longest path.
-            return a.turn > b.turn;
+        return max(0, min(settings.reduction, height - 1));
+    }
+
+    /* Searches the noisy moves of a state past the depth limit, so that states are not evaluated in the middle of a capture sequence. The player to
+       move may also stand pat, keeping the evaluation of the state instead of making a noisy move. Quiet moves are not searched, so only wins of the
+       player to move are solved. Nodes are counted by the caller. */
+    OptimalMove quiesce(int alpha, int beta, int ply, int remaining) {
+        if (position.is_game_over()) {
+            statistics.add_node(ply, true);
+            return OptimalMove(MoveType(), terminal_score(position.get_winner().value(), position.get_turn()), position.get_winner().value(), position.get_turn());
         }
 
-        if (a.score <= static_cast<double>(GameType::PLAYER_NONE)) { // Not losing, so prefer solved.
-            return a.winner.has_value() > b.winner.has_value();
+        OptimalMove ans(position.get_moves()[0], evaluation_score(position.evaluate()), nullopt, position.get_turn());
+        const vector<MoveType> noisy_moves = remaining > 0 ? position.get_noisy_moves() : vector<MoveType>();
+        const int player = position.get_player();
+        statistics.add_node(ply, noisy_moves.empty());
+
+        for (int i = 0; i < noisy_moves.size(); i++) {
+            // Pruning once the best of standing pat and the moves searched so far is good enough.
+            if (player == GameType::PLAYER_MAX ? max(alpha, ans.score) >= beta : min(beta, ans.score) <= alpha) {
+                if (i > 0) {
+                    statistics.add_cutoff(ply, i - 1);
+                }
+
+                break;
+            }
+
+            position.make_move(noisy_moves[i]);
+            nodes++;
+            OptimalMove ret = quiesce(player == GameType::PLAYER_MAX ? max(alpha, ans.score) : alpha, player == GameType::PLAYER_MIN ? min(beta, ans.score) : beta,
+                                      ply + 1, remaining - 1);
+            position.rollback();
+
+            if (player == GameType::PLAYER_MAX ? ret.score > ans.score : ret.score < ans.score) {
+                ans = ret;
+                ans.move = noisy_moves[i];
+
+                if (ans.winner != player) {
+                    ans.winner = nullopt;
+                }
+            }
         }
 
-        // Losing, so prefer unsolved.
-        return a.winner.has_value() < b.winner.has_value();
+        return ans;
     }
 
-    /* Recursive function that runs the Minimax algorithm with alpha-beta pruning. */
-    OptimalMove solve(double alpha, double beta, int height) {
-        // Leaf node.
-        if (game.is_game_over()) {
-            return OptimalMove(MoveType(), game.get_winner().value(), game.get_winner().value(), game.get_turn());
+    /* Returns the opening book move of the state and the depth it was searched to, if any. */
+    static optional<pair<OptimalMove, int>> probe_book(const GameType &game_) {
+        const optional<pair<typename OpeningBook<GameType>::Entry, MoveType>> book_move = book.probe(game_);
+
+        if (!book_move.has_value()) {
+            return nullopt;
+        }
+
+        const auto &[entry, move] = book_move.value();
+        OptimalMove ans(move, entry.score, nullopt, game_.get_turn() + entry.depth);
+
+        if (entry.winner != UNSOLVED) {
+            ans.winner = entry.winner;
         }
 
-        const vector<MoveType> moves = game.get_moves();
+        if (is_decisive(ans.score)) {
+            ans.score += ans.score > 0 ? -game_.get_turn() : game_.get_turn();
+            ans.turn = WIN_SCORE - abs(ans.score);
+        }
+
+        return make_pair(ans, entry.depth);
+    }
+
+    /* Recursive function that runs the Minimax algorithm with alpha-beta pruning. Height is the remaining depth and ply the distance to the root.
+       The transposition table key of the state is computed if it is not given. */
+    OptimalMove solve(int alpha, int beta, int height, int ply, const optional<pair<StateType, int>> &key_ = nullopt) {
+        nodes++;
 
-        // If we are too deep then evaluate the board.
+        // Leaf node.
+        if (position.is_game_over()) {
+            statistics.add_node(ply, true);
+            return OptimalMove(MoveType(), terminal_score(position.get_winner().value(), position.get_turn()), position.get_winner().value(), position.get_turn());
+        }
+
+        // If we are too deep then evaluate the board, once it is quiet.
         if (height == 0) {
-            next_depth_move_count += moves.size();
-            return OptimalMove(moves[0], game.evaluate(), nullopt, game.get_turn());
+            next_depth_move_count += position.get_moves().size();
+            return quiesce(alpha, beta, ply, settings.quiescence ? settings.max_quiescence_depth : 0);
         }
 
+        statistics.add_node(ply, false);
+
+        // Abandoning the search if it went past the deadline or the node limit, or was stopped. Reused results make the time estimate unreliable.
+        if (nodes % DEADLINE_CHECK_INTERVAL == 0 and chrono::high_resolution_clock::now() > deadline) {
+            abandoned = true;
+        }
+
+        if (nodes >= node_limit or (stop != nullptr and stop->load(memory_order_relaxed))) {
+            abandoned = true;
+        }
+
+        if (abandoned) {
+            return OptimalMove();
+        }
+
+        // Transposition table lookup. Symmetric states share an entry, whose move is mapped back.
+        const pair<StateType, int> key = key_.has_value() ? key_.value() : get_key();
+        const optional<TranspositionTable::Entry> entry = counted_probe(key.first);
+        const optional<MoveType> hint = entry.has_value() ? get_entry_move(entry.value(), key.second) : nullopt;
+
+        // The entry of the root doesn't know about the excluded moves.
+        const bool excluding = ply == 0 and !excluded_moves.empty();
+
+        if (hint.has_value() and entry->height >= height and !excluding) {
+            OptimalMove ans = get_entry_result(entry.value(), hint.value(), position.get_turn());
+
+            if (entry->bound == EXACT or (entry->bound == LOWER_BOUND and ans.score >= beta) or (entry->bound == UPPER_BOUND and ans.score <= alpha)) {
+                return ans;
+            }
+        }
+
+        vector<MoveType> moves = order_moves(position.get_moves(), hint);
+
+        if (excluding) {
+            moves.erase(remove_if(moves.begin(), moves.end(),
+                                  [&](const MoveType &move) { return find(excluded_moves.begin(), excluded_moves.end(), move) != excluded_moves.end(); }),
+                        moves.end());
+        }
+
+        const int original_alpha = alpha, original_beta = beta;
         previous_depths_move_count += moves.size();
 
         // Initializing with worst possible score.
         OptimalMove ans;
-        ans.score = 2.0 * game.get_enemy();
+        ans.score = position.get_enemy() * INFINITE_SCORE;
+
+        // Nothing scores better than the game ending in the next turn.
+        const int best_max = terminal_score(GameType::PLAYER_MAX, position.get_turn() + 1);
+        const int best_min = terminal_score(GameType::PLAYER_MIN, position.get_turn() + 1);
 
         for (int i = 0; i < moves.size(); i++) {
-            // Recurse.
-            game.make_move(moves[i]);
-            OptimalMove ret = solve(alpha, beta, height - 1);
-            game.rollback();
+            const int extension = get_extension(moves, moves[i], height, ply);
+            const int reduction = get_reduction(moves[i], i, height, extension);
+
+            // Recurse, loading the transposition table entry of the next state while the search gets to it.
+            position.make_move(moves[i]);
+            const bool repetition = position.is_repetition();
+            optional<pair<StateType, int>> next_key = nullopt;
 
-            if (game.get_player() == GameType::PLAYER_MAX) {
+            if (height - 1 + extension - reduction > 0 and !position.is_game_over()) {
+                next_key = get_key();
+                transposition_table->prefetch(next_key->first.hash());
+            }
+
+            OptimalMove ret = solve(alpha, beta, height - 1 + extension - reduction, ply + 1, next_key);
+
+            // Searching a reduced move again at full depth if it raises the bound of the player who made it.
+            if (reduction > 0 and !abandoned and (position.get_enemy() == GameType::PLAYER_MAX ? ret.score > alpha : ret.score < beta)) {
+                ret = solve(alpha, beta, height - 1 + extension, ply + 1, next_key);
+            }
+
+            position.rollback();
+            ret.hits_cycle = ret.hits_cycle or repetition;
+
+            if (abandoned) {
+                return ans;
+            }
+
+            if (position.get_player() == GameType::PLAYER_MAX) {
                 // Alpha-beta pruning.
                 alpha = max(alpha, ret.score);
 
                 // Max.
-                if (better_max(ret, ans)) {
+                if (ret.score > ans.score) {
                     ans = ret;
                     ans.move = moves[i];
                 }
-            } else if (game.get_player() == GameType::PLAYER_MIN) {
+            } else if (position.get_player() == GameType::PLAYER_MIN) {
                 // Alpha-beta pruning.
                 beta = min(beta, ret.score);
 
                 // Min.
-                if (better_min(ret, ans)) {
+                if (ret.score < ans.score) {
                     ans = ret;
                     ans.move = moves[i];
                 }
@@ -143,40 +684,182 @@ template <class GameType> class Minimax {
                 assert(false);
             }
 
-            if (alpha == static_cast<double>(GameType::PLAYER_MAX) or beta == static_cast<double>(GameType::PLAYER_MIN) or beta <= alpha) {
+            if (alpha >= best_max or beta <= best_min or beta <= alpha) {
                 ans.pruned = ans.pruned or i < moves.size() - 1; // Pruned if not all moves were considered.
+                statistics.add_cutoff(ply, i);
+                history[get_player_index(position.get_player())][moves[i]] += height * height;
                 break;
             }
         }
 
+        // Transposition table update.
+        if (excluding) {
+            return ans;
+        }
+
+        if (ans.score <= original_alpha) {
+            store(key, ans, height, UPPER_BOUND);
+        } else if (ans.score >= original_beta) {
+            store(key, ans, height, LOWER_BOUND);
+        } else {
+            store(key, ans, height, EXACT);
+        }
+
         return ans;
     }
 
   public:
-    Minimax() = default;
+    Minimax() : Minimax(Settings()) {}
+
+    /* Uses the given transposition table if any, which can be shared with other Minimax of the same game running on other threads. */
+    Minimax(const Settings &settings_, shared_ptr<TranspositionTable> transposition_table_ = nullptr) : settings(settings_) {
+        shared_transposition_table = transposition_table_ != nullptr;
+        transposition_table = transposition_table_;
+
+        if (!shared_transposition_table) {
+            transposition_table = make_transposition_table(settings);
+        }
+    }
+
+    /* Returns a transposition table as configured by the settings. It stays in memory if its file can't be mapped. */
+    static shared_ptr<TranspositionTable> make_transposition_table(const Settings &settings_) {
+        shared_ptr<TranspositionTable> table = make_shared<TranspositionTable>(settings_.transposition_table_megabytes, settings_.huge_pages);
+
+        if (!settings_.transposition_table_path.empty()) {
+            table->open(settings_.transposition_table_path, settings_.transposition_table_megabytes, typeid(GameType).name(),
+                        settings_.transposition_table_read_only);
+        }
+
+        return table;
+    }
+
+    Minimax(const Minimax &) = delete;
+    Minimax &operator=(const Minimax &) = delete;
     ~Minimax() = default;
 
+    /* Returns the principal variation found by the last get_move call. */
+    const vector<MoveType> &get_principal_variation() const {
+        return principal_variation;
+    }
+
+    /* Returns the best root moves found by the last get_move call with Settings::multi_pv > 1, best first. Empty for opening book moves. */
+    const vector<Line> &get_lines() const {
+        return lines;
+    }
+
+    /* Returns the opening book entry of a move found by get_move in the current state of the game. */
+    static typename OpeningBook<GameType>::Entry make_book_entry(const GameType &game_, const OptimalMove &ans, int depth) {
+        typename OpeningBook<GameType>::Entry entry;
+        entry.key = OpeningBook<GameType>::get_key(game_.get_state());
+        entry.score = ans.score;
+        entry.move = OpeningBook<GameType>::get_move_hash(ans.move);
+        entry.depth = min(depth, static_cast<int>(numeric_limits<uint8_t>::max()));
+        entry.winner = ans.winner.has_value() ? ans.winner.value() : UNSOLVED;
+
+        if (is_decisive(entry.score)) {
+            entry.score += entry.score > 0 ? game_.get_turn() : -game_.get_turn();
+        }
+
+        return entry;
+    }
+
+    /* Forgets everything learned by previous get_move calls. */
+    void clear() {
+        clear_search_state();
+    }
+
     /* Returns the best move obtained with minimax given a time limit in milliseconds. */
-    pair<OptimalMove, int> get_move(const GameType &game_, chrono::duration<long double> timeout) {
+    tuple<OptimalMove, int, SearchStatistics> get_move(const GameType &game_, chrono::duration<long double> timeout) {
+        Limits limits;
+        limits.timeout = timeout;
+        return get_move(game_, limits);
+    }
+
+    /* Returns the best move obtained with minimax within the given limits, the last depth completed and what the search did. Searches until the game
+       is solved if there are no limits. The progress callback, if any, is called after every depth. */
+    tuple<OptimalMove, int, SearchStatistics> get_move(const GameType &game_, const Limits &limits, const function<void(const Progress &)> &progress = nullptr) {
         chrono::time_point<chrono::high_resolution_clock> get_move_start_time_point, previous_solve_start_time_point;
         chrono::duration<long double> total_time, last_solve_time, next_solve_time;
-        OptimalMove prev_ans, cur_ans;
+        OptimalMove cur_ans;
+        vector<Line> cur_lines;
+        lines.clear();
+
+        // Playing from the opening book without searching.
+        if (settings.opening_book) {
+            optional<pair<OptimalMove, int>> book_move = probe_book(game_);
+
+            if (book_move.has_value()) {
+                return {book_move->first, book_move->second, SearchStatistics()};
+            }
+        }
 
         // Timing.
         get_move_start_time_point = chrono::high_resolution_clock::now();
 
         // Initializing.
         int max_depth = 0;
-        game = game_;
+        position = SearchPosition<GameType>(game_);
+        generation = transposition_table->new_generation();
+        nodes = 0;
+        statistics = SearchStatistics();
+        node_limit = limits.nodes.value_or(numeric_limits<long long>::max());
+        stop = limits.stop;
+        abandoned = false;
+
+        // Answering with the first move if the search is stopped before depth 0 finishes.
+        if (!game_.is_game_over()) {
+            cur_ans = OptimalMove(game_.get_moves()[0], evaluation_score(game_.evaluate()), nullopt, game_.get_turn());
+        }
+
+        if (limits.timeout.has_value()) {
+            deadline = get_move_start_time_point + chrono::duration_cast<chrono::high_resolution_clock::duration>(1.5 * limits.timeout.value());
+        } else {
+            deadline = chrono::time_point<chrono::high_resolution_clock>::max();
+        }
+
+        // Reusing what was learned in the previous get_move calls.
+        if (settings.persistent) {
+            age_search_state();
+            advance_principal_variation(game_);
+            seed_principal_variation();
+        } else {
+            clear_search_state();
+        }
 
         // Iterative Deepening Search.
         do {
             // Calling solve.
             previous_solve_start_time_point = chrono::high_resolution_clock::now();
             previous_depths_move_count = next_depth_move_count = 0;
-            prev_ans = cur_ans;
-            cur_ans = solve(2.0 * GameType::PLAYER_MIN, 2.0 * GameType::PLAYER_MAX, max_depth++);
+            iteration_depth = max_depth;
+            long long previous_nodes = nodes;
+            OptimalMove ans = solve(-INFINITE_SCORE, INFINITE_SCORE, max_depth, 0);
+            vector<Line> ans_lines;
+
+            // Finding the next best root moves. They are part of the iteration, so the time prediction accounts for them.
+            if (settings.multi_pv > 1 and !abandoned) {
+                long long best_nodes = nodes;
+                ans_lines = search_lines(ans, max_depth);
+                statistics.multi_pv_nodes += nodes - best_nodes;
+            }
+
             last_solve_time = chrono::high_resolution_clock::now() - previous_solve_start_time_point;
+            statistics.add_iteration({max_depth, nodes - previous_nodes, static_cast<double>(last_solve_time.count()), !abandoned, ans.evaluation()});
+
+            // Keeping the last finished depth.
+            if (abandoned) {
+                break;
+            }
+
+            cur_ans = ans;
+            cur_lines = ans_lines;
+            max_depth++;
+            principal_variation = cur_lines.empty() ? get_table_line(max_depth) : cur_lines[0].principal_variation;
+
+            if (progress != nullptr) {
+                chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - get_move_start_time_point;
+                progress({max_depth - 1, cur_ans, principal_variation, nodes, elapsed.count(), cur_lines});
+            }
 
             // Predicting how much it will take for another solve call.
             if (previous_depths_move_count == 0) {
@@ -189,14 +872,39 @@ template <class GameType> class Minimax {
 
             // Calculating total time elapsed so far.
             total_time = chrono::high_resolution_clock::now() - get_move_start_time_point;
-        } while (!cur_ans.winner.has_value() and total_time + next_solve_time < 1.5 * timeout);
+        } while (!cur_ans.winner.has_value() and (!limits.timeout.has_value() or total_time + next_solve_time < 1.5 * limits.timeout.value()) and
+                 (!limits.depth.has_value() or max_depth <= limits.depth.value()));
 
-        // Optimal move in case of a loss.
-        if (cur_ans.winner.has_value() and cur_ans.winner.value() == game.get_enemy() and max_depth > 1) {
-            cur_ans.move = prev_ans.move;
-        }
+        principal_variation_root = game_.get_state();
+        principal_variation_turn = game_.get_turn();
+
+        // Returning optimal move, with the depth that iterative deepening completed. Results reused from previous get_move calls may come from deeper
+        // searches, but they only make the iterations cheaper.
+        lines = cur_lines;
+        statistics.nodes = nodes;
+        return {cur_ans, max_depth - 1, statistics};
+    }
+
+    /* Starts get_move on a new thread and returns immediately. Limits::stop is replaced by AsyncSearch::stop, and the progress callback, if any, is
+       called from the search thread. This Minimax must not be used or destroyed until the search ends. */
+    AsyncSearch start_search(const GameType &game_, Limits limits, function<void(const Progress &)> progress = nullptr) {
+        AsyncSearch search;
+        search.state = make_shared<typename AsyncSearch::SharedState>();
+        limits.stop = &search.state->stop;
+
+        search.result = async(launch::async, [this, game_, limits, progress, state = search.state]() {
+            return get_move(game_, limits, [&](const Progress &progress_) {
+                {
+                    lock_guard<mutex> lock(state->progress_mutex);
+                    state->progress = progress_;
+                }
+
+                if (progress != nullptr) {
+                    progress(progress_);
+                }
+            });
+        }).share();
 
-        // Returning optimal move.
-        return {cur_ans, max_depth - 1};
+        return search;
     }
 };
\ No newline at end of file
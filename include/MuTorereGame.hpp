@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <vector>
@@ -15,11 +17,21 @@ class MuTorereMove : public GameMove {
     MuTorereMove() : pos(-1) {}
     MuTorereMove(int pos_) : pos(pos_) {}
 
+    bool operator==(const MuTorereMove &m) const {
+        return pos == m.pos;
+    }
+
     operator string() const override {
         return "(" + to_string(pos) + ")";
     }
 };
 
+template <> struct std::hash<MuTorereMove> {
+    size_t operator()(const MuTorereMove &m) const {
+        return std::hash<int>()(m.pos);
+    }
+};
+
 class MuTorereState : public GameState {
   private:
     int state_;
@@ -34,9 +46,7 @@ class MuTorereState : public GameState {
         return to_string(state_);
     }
 
-    static MuTorereState deserialize(const string &serialized_state) {
-        return MuTorereState(stoi(serialized_state));
-    }
+    static MuTorereState deserialize(const string &);
 
     int get() const {
         return state_;
@@ -58,10 +68,78 @@ class MuTorereGame : public Game<MuTorereState, MuTorereMove> {
     static constexpr int BLACK = Game<MuTorereState, MuTorereMove>::PLAYER_MIN;
     static constexpr int NONE = Game<MuTorereState, MuTorereMove>::PLAYER_NONE;
 
-    int board[N + 1]; // 0 through 7 belong to the circle. 8 is the center.
+    /* Symmetries of the circle: N rotations, each one optionally preceded by a reflection. The center is kept. */
+    static constexpr int SYMMETRIES = 2 * N;
+
+    /* Returns the position mapped by the given symmetry. */
+    static int get_symmetric_position(int p, int symmetry) {
+        if (p < 0 or p >= N) {
+            return p;
+        }
+
+        return ((symmetry >= N ? N - p : p) + symmetry) % N;
+    }
+
+    /* Returns the digit of a cell in the encoded state. */
+    static constexpr int get_digit(int cell) {
+        return cell == WHITE ? 0 : (cell == BLACK ? 1 : 2);
+    }
+
+    /* Encoded boards, one base 3 digit per cell: 3^(N + 1). The current player is the next digit. */
+    static constexpr int ENCODED_BOARDS = 19683;
+
+    /* States of the tables: the current player, the empty position and which of the other N cells are black. Positions 0 through 7 belong to the
+       circle and 8 is the center. */
+    static constexpr int BOARD_STATES = (N + 1) << N;
+    static constexpr int STATES = 2 * BOARD_STATES;
+
+    /* Most moves of a state: with an empty center, up to five pieces of the player can be next to an enemy, as in w b w w b w w b. */
+    static constexpr int MAX_MOVES = 5;
+
+    /* Legal moves of a state and the states they lead to. */
+    class Transition {
+      public:
+        int state;               // Encoded state.
+        int moves;               // Number of legal moves.
+        int8_t pos[MAX_MOVES];   // Positions of the moves, in increasing order.
+        int16_t next[MAX_MOVES]; // State reached by each move.
+    };
 
-    /* Returns the position which is empty. */
-    int get_empty_position();
+    static const array<Transition, STATES> TRANSITIONS;  // Transitions of every state.
+    static const array<int16_t, ENCODED_BOARDS> BOARDS; // State of each encoded board with WHITE to play, or -1 if it hasn't one empty cell.
+
+    int index; // Current state of the tables.
+
+    /* Returns the cell of a position in a state of the tables. */
+    static constexpr int get_cell(int index_, int p) {
+        int empty = index_ % BOARD_STATES >> N;
+
+        if (p == empty) {
+            return NONE;
+        }
+
+        return (index_ >> (p - (p > empty))) & 1 ? BLACK : WHITE;
+    }
+
+    /* Returns the current player of a state of the tables. */
+    static constexpr int get_index_player(int index_) {
+        return index_ < BOARD_STATES ? WHITE : BLACK;
+    }
+
+    /* Returns the state of the tables of a board with one empty cell. */
+    static constexpr int get_index(const int (&)[N + 1], int player);
+
+    /* Returns the given board and player as an encoded state. */
+    static constexpr int encode(const int (&)[N + 1], int player);
+
+    /* Returns true if the rules allow moving the piece in the given position in a state of the tables. */
+    static constexpr bool is_legal(int index_, int p);
+
+    /* Computes the tables at compile time. */
+    static constexpr array<Transition, STATES> get_transitions();
+    static constexpr array<int16_t, ENCODED_BOARDS> get_boards();
+
+    friend class MuTorereState;
 
   protected:
     /* Returns the current game state converted to State. */
@@ -70,7 +148,7 @@ class MuTorereGame : public Game<MuTorereState, MuTorereMove> {
     /* Loads the game given a State. */
     void load_game_(const MuTorereState &) override;
 
-    /* Performs a move. Assumes that is_valid_move(m) is true. TODO: Remove assumption that is_valid_move(m) is true. */
+    /* Performs a move. Assumes that is_valid_move(m) is true. */
     void make_move_(const MuTorereMove &) override;
 
     /* Returns a move inputed by the player. */
@@ -82,6 +160,15 @@ class MuTorereGame : public Game<MuTorereState, MuTorereMove> {
     /* Returns the winner. */
     using Game<MuTorereState, MuTorereMove>::get_winner_;
 
+    /* Returns the smallest of the states that are symmetric to the current one, and the symmetry that maps the current state into it. */
+    pair<MuTorereState, int> get_canonical_state_() const override;
+
+    /* Returns the move mapped by the given symmetry. */
+    MuTorereMove get_symmetric_move_(const MuTorereMove &, int) const override;
+
+    /* Returns the symmetry that undoes the given symmetry. */
+    int get_inverse_symmetry_(int) const override;
+
   public:
     MuTorereGame();
     MuTorereGame(const MuTorereState &);
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__GNUC__) and (defined(__x86_64__) or defined(__i386__))
+#include <immintrin.h>
+#define NETWORK_AVX2
+#endif
+
+using namespace std;
+
+/* Small quantized network evaluating positions from their one-hot inputs. The first layer is kept in accumulators that are updated incrementally
+   with the inputs that change between positions. Uses AVX2 when the CPU supports it and integer scalar code otherwise, with identical results. */
+template <int INPUTS> class Network {
+  public:
+    /* Layer sizes. */
+    static constexpr int INPUT_COUNT = INPUTS;
+    static constexpr int HIDDEN1 = 64;
+    static constexpr int HIDDEN2 = 32;
+
+    /* Quantization. Activations are in [0, ACTIVATION_SCALE], and weights after the first layer are multiplied by WEIGHT_SCALE. */
+    static constexpr int ACTIVATION_SCALE = 127;
+    static constexpr int WEIGHT_SCALE = 64;
+    static constexpr int WEIGHT_SHIFT = 6;
+
+    /* Quantized weights, as stored in the network file after its header. */
+    class Weights {
+      public:
+        alignas(32) int16_t input_weights[INPUTS][HIDDEN1]; // Scaled by ACTIVATION_SCALE.
+        alignas(32) int16_t input_biases[HIDDEN1];          // Scaled by ACTIVATION_SCALE.
+        alignas(32) int8_t hidden_weights[HIDDEN2][HIDDEN1]; // Scaled by WEIGHT_SCALE.
+        int32_t hidden_biases[HIDDEN2];                      // Scaled by ACTIVATION_SCALE * WEIGHT_SCALE.
+        int8_t output_weights[HIDDEN2];                      // Scaled by WEIGHT_SCALE.
+        int32_t output_bias;                                 // Scaled by ACTIVATION_SCALE * WEIGHT_SCALE.
+    };
+
+    /* First layer of the network before its activation, for the given inputs. */
+    class Accumulator {
+      public:
+        alignas(32) int16_t values[HIDDEN1];
+        bitset<INPUTS> inputs;
+    };
+
+    /* Accumulators of the positions along the current line. Moves push an updated copy of the top and rollbacks pop it. */
+    class AccumulatorStack {
+      private:
+        static constexpr int MAX_SIZE = 1024; // The stack restarts from its top when a game never rolls back.
+
+        vector<Accumulator> stack;
+
+      public:
+        bool empty() const {
+            return stack.empty();
+        }
+
+        const Accumulator &top() const {
+            return stack.back();
+        }
+
+        /* Moves the top of the stack to the given inputs. Inputs equal to the ones below the top are a rollback. */
+        void update(const Network &network, const bitset<INPUTS> &inputs) {
+            if (stack.size() >= 2 and stack[stack.size() - 2].inputs == inputs) {
+                stack.pop_back();
+                return;
+            }
+
+            if (stack.size() >= MAX_SIZE) {
+                stack.erase(stack.begin(), stack.end() - 1);
+            }
+
+            if (stack.empty()) {
+                stack.emplace_back();
+                network.refresh(stack.back(), inputs);
+            } else {
+                stack.push_back(stack.back());
+                network.update(stack.back(), inputs);
+            }
+        }
+    };
+
+  private:
+    /* File header. */
+    static constexpr char MAGIC[4] = {'M', 'M', 'N', 'N'};
+    static constexpr int32_t VERSION = 1;
+
+    /* More changed inputs than this are cheaper to refresh from scratch. */
+    static constexpr int MAX_UPDATED_INPUTS = 8;
+
+    Weights weights; // Weights.
+    bool loaded = false;
+
+#ifdef NETWORK_AVX2
+    /* Returns true if the CPU supports AVX2. */
+    static bool has_avx2() {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+    }
+
+    /* Adds (sign = 1) or subtracts (sign = -1) an input row to the accumulator. */
+    __attribute__((target("avx2"))) static void add_row_avx2(int16_t *values, const int16_t *row, int sign) {
+        for (int i = 0; i < HIDDEN1; i += 16) {
+            __m256i value = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i));
+            __m256i weight = _mm256_load_si256(reinterpret_cast<const __m256i *>(row + i));
+            value = sign > 0 ? _mm256_add_epi16(value, weight) : _mm256_sub_epi16(value, weight);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(values + i), value);
+        }
+    }
+
+    /* Returns the output of the network for the accumulator. */
+    __attribute__((target("avx2"))) int32_t forward_avx2(const Accumulator &accumulator) const {
+        // Clipped ReLU of the first layer, packed into bytes. Packing interleaves the 128 bit lanes, which the permutation undoes.
+        alignas(32) uint8_t activations[HIDDEN1];
+        __m256i maximum = _mm256_set1_epi16(ACTIVATION_SCALE);
+
+        for (int i = 0; i < HIDDEN1; i += 32) {
+            __m256i a = _mm256_min_epi16(_mm256_load_si256(reinterpret_cast<const __m256i *>(accumulator.values + i)), maximum);
+            __m256i b = _mm256_min_epi16(_mm256_load_si256(reinterpret_cast<const __m256i *>(accumulator.values + i + 16)), maximum);
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(activations + i), packed);
+        }
+
+        // Second layer. Products of unsigned activations and signed weights are summed in pairs, and then in groups of 4.
+        int32_t output = weights.output_bias;
+        __m256i ones = _mm256_set1_epi16(1);
+
+        for (int j = 0; j < HIDDEN2; j++) {
+            __m256i sum = _mm256_setzero_si256();
+
+            for (int i = 0; i < HIDDEN1; i += 32) {
+                __m256i activation = _mm256_load_si256(reinterpret_cast<const __m256i *>(activations + i));
+                __m256i weight = _mm256_load_si256(reinterpret_cast<const __m256i *>(weights.hidden_weights[j] + i));
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(activation, weight), ones));
+            }
+
+            __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+
+            int32_t hidden = clamp((weights.hidden_biases[j] + _mm_cvtsi128_si32(half)) >> WEIGHT_SHIFT, 0, ACTIVATION_SCALE);
+            output += hidden * weights.output_weights[j];
+        }
+
+        return output;
+    }
+#endif
+
+    /* Adds (sign = 1) or subtracts (sign = -1) an input row to the accumulator. */
+    static void add_row_scalar(int16_t *values, const int16_t *row, int sign) {
+        for (int i = 0; i < HIDDEN1; i++) {
+            values[i] += sign * row[i];
+        }
+    }
+
+    /* Returns the output of the network for the accumulator. */
+    int32_t forward_scalar(const Accumulator &accumulator) const {
+        uint8_t activations[HIDDEN1];
+
+        for (int i = 0; i < HIDDEN1; i++) {
+            activations[i] = clamp<int>(accumulator.values[i], 0, ACTIVATION_SCALE);
+        }
+
+        int32_t output = weights.output_bias;
+
+        for (int j = 0; j < HIDDEN2; j++) {
+            int32_t sum = weights.hidden_biases[j];
+
+            for (int i = 0; i < HIDDEN1; i++) {
+                sum += activations[i] * weights.hidden_weights[j][i];
+            }
+
+            output += clamp(sum >> WEIGHT_SHIFT, 0, ACTIVATION_SCALE) * weights.output_weights[j];
+        }
+
+        return output;
+    }
+
+    /* Adds (sign = 1) or subtracts (sign = -1) an input row to the accumulator. */
+    void add_row(Accumulator &accumulator, int input, int sign) const {
+#ifdef NETWORK_AVX2
+        if (has_avx2()) {
+            add_row_avx2(accumulator.values, weights.input_weights[input], sign);
+            return;
+        }
+#endif
+
+        add_row_scalar(accumulator.values, weights.input_weights[input], sign);
+    }
+
+  public:
+    /* Returns true if a network file has been loaded. */
+    bool is_loaded() const {
+        return loaded;
+    }
+
+    /* Returns the quantized weights. */
+    const Weights &get_weights() const {
+        return weights;
+    }
+
+    /* Replaces the quantized weights. */
+    void set_weights(const Weights &weights_) {
+        weights = weights_;
+        loaded = true;
+    }
+
+    /* Loads a network file. Returns false, keeping the network unloaded, if the file can't be read or was made for other inputs. */
+    bool load(const string &path) {
+        FILE *file = fopen(path.c_str(), "rb");
+
+        if (file == nullptr) {
+            return false;
+        }
+
+        char magic[4];
+        int32_t version, inputs, hidden1, hidden2;
+        bool valid = fread(magic, sizeof(magic), 1, file) == 1 and fread(&version, sizeof(version), 1, file) == 1 and
+                     fread(&inputs, sizeof(inputs), 1, file) == 1 and fread(&hidden1, sizeof(hidden1), 1, file) == 1 and
+                     fread(&hidden2, sizeof(hidden2), 1, file) == 1;
+
+        valid = valid and memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 and version == VERSION and inputs == INPUTS and hidden1 == HIDDEN1 and hidden2 == HIDDEN2;
+        valid = valid and fread(&weights, sizeof(weights), 1, file) == 1;
+        fclose(file);
+
+        loaded = valid;
+        return valid;
+    }
+
+    /* Saves the network. Returns false if the file can't be written. */
+    bool save(const string &path) const {
+        FILE *file = fopen(path.c_str(), "wb");
+
+        if (file == nullptr) {
+            return false;
+        }
+
+        int32_t header[4] = {VERSION, INPUTS, HIDDEN1, HIDDEN2};
+        bool valid = fwrite(MAGIC, sizeof(MAGIC), 1, file) == 1 and fwrite(header, sizeof(header), 1, file) == 1 and fwrite(&weights, sizeof(weights), 1, file) == 1;
+        return fclose(file) == 0 and valid;
+    }
+
+    /* Computes the accumulator of the inputs from scratch. */
+    void refresh(Accumulator &accumulator, const bitset<INPUTS> &inputs) const {
+        memcpy(accumulator.values, weights.input_biases, sizeof(accumulator.values));
+        accumulator.inputs = inputs;
+
+        for (int input = inputs._Find_first(); input < INPUTS; input = inputs._Find_next(input)) {
+            add_row(accumulator, input, 1);
+        }
+    }
+
+    /* Updates the accumulator with the inputs that changed. */
+    void update(Accumulator &accumulator, const bitset<INPUTS> &inputs) const {
+        bitset<INPUTS> changed = accumulator.inputs ^ inputs;
+
+        if (changed.count() > MAX_UPDATED_INPUTS) {
+            refresh(accumulator, inputs);
+            return;
+        }
+
+        for (int input = changed._Find_first(); input < INPUTS; input = changed._Find_next(input)) {
+            add_row(accumulator, input, inputs[input] ? 1 : -1);
+        }
+
+        accumulator.inputs = inputs;
+    }
+
+    /* Returns the raw output of the network, scaled by ACTIVATION_SCALE * WEIGHT_SCALE. */
+    int32_t forward(const Accumulator &accumulator) const {
+#ifdef NETWORK_AVX2
+        if (has_avx2()) {
+            return forward_avx2(accumulator);
+        }
+#endif
+
+        return forward_scalar(accumulator);
+    }
+
+    /* Returns a value between -1 and 1 indicating how probable it is for the first player to win (1.0) or the other player to win (-1.0). */
+    double evaluate(const Accumulator &accumulator) const {
+        return tanh(forward(accumulator) / static_cast<double>(ACTIVATION_SCALE * WEIGHT_SCALE));
+    }
+
+    /* Returns the evaluation of the inputs without an accumulator stack. */
+    double evaluate(const bitset<INPUTS> &inputs) const {
+        Accumulator accumulator;
+        refresh(accumulator, inputs);
+        return evaluate(accumulator);
+    }
+};
\ No newline at end of file
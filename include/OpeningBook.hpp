@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Game.hpp>
+
+using namespace std;
+
+/* Moves of the first plies of a game found by deep offline searches (tools/book.cpp). Stored as fixed size entries sorted by the hash of their
+   serialized state, which is stable between builds, and looked up with a binary search. Moves are stored as their hash, like in the transposition
+   table, so that a book keeps playing the same moves if the order of Game::get_moves changes. */
+template <class GameType> class OpeningBook {
+  public:
+    using StateType = typename GameType::state_type;
+    using MoveType = typename GameType::move_type;
+
+    class Entry {
+      public:
+        uint64_t key = 0;  // Hash of the serialized state.
+        int32_t score = 0; // Minimax score. Win/loss scores are relative to the turn of the state.
+        uint32_t move = 0; // std::hash of the move.
+        uint8_t depth = 0; // Depth of the search.
+        int8_t winner = 0; // Winner of the best line, or Minimax's UNSOLVED.
+    };
+
+  private:
+    /* File header. */
+    static constexpr char MAGIC[4] = {'M', 'M', 'B', 'K'};
+    static constexpr int32_t VERSION = 2;
+
+    /* FNV-1a constants. */
+    static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+    static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+    vector<Entry> entries; // Sorted by key.
+
+  public:
+    /* Returns the key of a state. */
+    static uint64_t get_key(const StateType &state) {
+        uint64_t key = FNV_OFFSET_BASIS;
+
+        for (unsigned char c : state.serialize()) {
+            key = (key ^ c) * FNV_PRIME;
+        }
+
+        return key;
+    }
+
+    /* Returns the hash of a move stored in the book. */
+    static uint32_t get_move_hash(const MoveType &move) {
+        return static_cast<uint32_t>(std::hash<MoveType>()(move));
+    }
+
+    /* Returns true if the book has no entries. */
+    bool empty() const {
+        return entries.empty();
+    }
+
+    /* Returns the number of entries. */
+    size_t size() const {
+        return entries.size();
+    }
+
+    /* Replaces the entries. */
+    void set_entries(vector<Entry> entries_) {
+        entries = move(entries_);
+        sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.key < b.key; });
+    }
+
+    /* Returns the entry of the current state of the game and its move, or nullopt if the state is not in the book or its move is not legal. */
+    optional<pair<Entry, MoveType>> probe(const GameType &game) const {
+        if (entries.empty()) {
+            return nullopt;
+        }
+
+        uint64_t key = get_key(game.get_state());
+        auto it = lower_bound(entries.begin(), entries.end(), key, [](const Entry &entry, uint64_t key_) { return entry.key < key_; });
+
+        if (it == entries.end() or it->key != key) {
+            return nullopt;
+        }
+
+        for (const MoveType &move : game.get_moves()) {
+            if (get_move_hash(move) == it->move) {
+                return make_pair(*it, move);
+            }
+        }
+
+        return nullopt;
+    }
+
+    /* Loads a book file. Returns false, leaving the book empty, if the file can't be read. */
+    bool load(const string &path) {
+        entries.clear();
+        FILE *file = fopen(path.c_str(), "rb");
+
+        if (file == nullptr) {
+            return false;
+        }
+
+        char magic[4];
+        int32_t version;
+        uint64_t count;
+        bool valid = fread(magic, sizeof(magic), 1, file) == 1 and fread(&version, sizeof(version), 1, file) == 1 and
+                     fread(&count, sizeof(count), 1, file) == 1 and memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 and version == VERSION;
+
+        if (valid) {
+            entries.resize(count);
+            valid = count == 0 or fread(entries.data(), sizeof(Entry), count, file) == count;
+        }
+
+        fclose(file);
+
+        if (!valid) {
+            entries.clear();
+        }
+
+        return valid;
+    }
+
+    /* Saves the book. Returns false if the file can't be written. */
+    bool save(const string &path) const {
+        FILE *file = fopen(path.c_str(), "wb");
+
+        if (file == nullptr) {
+            return false;
+        }
+
+        uint64_t count = entries.size();
+        bool valid = fwrite(MAGIC, sizeof(MAGIC), 1, file) == 1 and fwrite(&VERSION, sizeof(VERSION), 1, file) == 1 and
+                     fwrite(&count, sizeof(count), 1, file) == 1 and (count == 0 or fwrite(entries.data(), sizeof(Entry), count, file) == count);
+        return fclose(file) == 0 and valid;
+    }
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+/* Tunable evaluation parameter. Parameters register themselves by name, so that a parameter file can override their default values. */
+class Parameter {
+  private:
+    string name; // Unique name, prefixed by the game name.
+    double value; // Current value.
+
+  public:
+    Parameter(const string &name_, double value_);
+    Parameter(const Parameter &) = delete;
+    Parameter &operator=(const Parameter &) = delete;
+
+    const string &get_name() const {
+        return name;
+    }
+
+    double get() const {
+        return value;
+    }
+
+    void set(double value_) {
+        value = value_;
+    }
+};
+
+/* Registry of every Parameter. Parameter files have one "name value" pair per line. */
+class Parameters {
+  private:
+    /* Returns the registered parameters sorted by name. Function-local, so that it exists before any static Parameter is constructed. */
+    static map<string, Parameter *> &get_registry() {
+        static map<string, Parameter *> registry;
+        return registry;
+    }
+
+  public:
+    /* Registers a parameter. */
+    static void add(Parameter *parameter) {
+        get_registry()[parameter->get_name()] = parameter;
+    }
+
+    /* Returns the parameter with the given name, or nullptr if there is none. */
+    static Parameter *find(const string &name) {
+        auto it = get_registry().find(name);
+        return it == get_registry().end() ? nullptr : it->second;
+    }
+
+    /* Loads a parameter file. Unknown names are ignored and missing ones keep their values. Returns false if the file can't be read. */
+    static bool load(const string &path) {
+        ifstream file(path);
+        string line;
+
+        if (!file) {
+            return false;
+        }
+
+        while (getline(file, line)) {
+            istringstream line_stream(line);
+            string name;
+            double value;
+
+            if (line_stream >> name >> value and find(name) != nullptr) {
+                find(name)->set(value);
+            }
+        }
+
+        return true;
+    }
+
+    /* Saves every registered parameter. Returns false if the file can't be written. */
+    static bool save(const string &path) {
+        FILE *file = fopen(path.c_str(), "w");
+
+        if (file == nullptr) {
+            return false;
+        }
+
+        for (const auto &[name, parameter] : get_registry()) {
+            fprintf(file, "%s %.9g\n", name.c_str(), parameter->get());
+        }
+
+        fclose(file);
+        return true;
+    }
+};
+
+inline Parameter::Parameter(const string &name_, double value_) : name(name_), value(value_) {
+    Parameters::add(this);
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <Game.hpp>
+
+using namespace std;
+
+/* Counts the leaves of the game tree of games derived from Game class, using only get_moves, make_move and rollback. */
+template <class GameType> class Perft {
+  public:
+    using StateType = typename GameType::state_type;
+    using MoveType = typename GameType::move_type;
+
+    class Settings {
+      public:
+        bool bulk = true; // Count the moves of the last ply instead of making them.
+        int threads = 1;  // Number of threads the root moves are split among.
+    };
+
+  private:
+    Settings settings; // Settings.
+
+    /* Recursive function that counts the leaves at the given depth below the current state. */
+    long long count(GameType &game, int depth) const {
+        if (depth <= 0) {
+            return 1;
+        }
+
+        if (settings.bulk and depth == 1) {
+            return game.get_moves().size();
+        }
+
+        const vector<MoveType> moves = game.get_moves();
+        long long leaves = 0;
+
+        for (const MoveType &move : moves) {
+            game.make_move(move);
+            leaves += count(game, depth - 1);
+            game.rollback();
+        }
+
+        return leaves;
+    }
+
+  public:
+    Perft() = default;
+    Perft(const Settings &settings_) : settings(settings_) {}
+    ~Perft() = default;
+
+    /* Returns the number of leaves below each root move. Root moves are split among the threads, each one with its own copy of the game. A depth
+       below 1 doesn't reach the root moves, so none are returned. */
+    vector<pair<MoveType, long long>> divide(const GameType &game_, int depth) const {
+        if (depth < 1) {
+            return {};
+        }
+
+        const vector<MoveType> &moves = game_.get_moves();
+        vector<pair<MoveType, long long>> ans(moves.size());
+        atomic<int> next_move = 0;
+
+        auto worker = [&]() {
+            GameType game = game_;
+
+            for (int i = next_move++; i < moves.size(); i = next_move++) {
+                game.make_move(moves[i]);
+                ans[i] = {moves[i], count(game, depth - 1)};
+                game.rollback();
+            }
+        };
+
+        vector<thread> threads;
+
+        for (int i = 1; i < settings.threads; i++) {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+
+        for (thread &t : threads) {
+            t.join();
+        }
+
+        return ans;
+    }
+
+    /* Returns the number of leaves at the given depth below the current state of the game. */
+    long long run(const GameType &game, int depth) const {
+        if (depth <= 0) {
+            return 1;
+        }
+
+        long long leaves = 0;
+
+        for (const pair<MoveType, long long> &p : divide(game, depth)) {
+            leaves += p.second;
+        }
+
+        return leaves;
+    }
+};
@@ -0,0 +1,487 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <Game.hpp>
+#include <Minimax.hpp>
+
+using namespace std;
+
+/* Depth-first proof-number search (df-pn) for games derived from Game class. Proves or disproves that a player wins. */
+template <class GameType> class ProofNumber {
+  public:
+    using StateType = typename GameType::state_type;
+    using MoveType = typename GameType::move_type;
+    using OptimalMove = typename Minimax<GameType>::OptimalMove;
+
+    class Limits {
+      public:
+        optional<chrono::duration<long double>> timeout = nullopt; // Time limit.
+        optional<long long> nodes = nullopt;                       // Node limit.
+    };
+
+    class Settings {
+      public:
+        size_t transposition_table_capacity = 1 << 20; // Maximum number of transposition table entries of each attacker.
+        bool symmetries = true;                        // Share transposition table entries between symmetric states.
+    };
+
+    class Result {
+      public:
+        optional<int> winner = nullopt;        // Proven winner with perfect play, or nullopt if the limits were reached first.
+        vector<MoveType> principal_variation; // Solved line, from the root until the game ends or repeats a state.
+        long long proof_tree_size = 0;        // Number of distinct states in the proof (or disproof) tree of the verdict.
+        long long nodes = 0;                  // Searched nodes.
+    };
+
+  private:
+    /* Proof and disproof numbers are capped below INFINITE_NUMBER, which marks proven or disproven states. */
+    static constexpr uint32_t INFINITE_NUMBER = numeric_limits<uint32_t>::max();
+
+    /* Number of nodes between two deadline checks. */
+    static constexpr int DEADLINE_CHECK_INTERVAL = 1024;
+
+    class TranspositionEntry {
+      public:
+        uint32_t proof = 1;          // Proof number, in the view of the attacker.
+        uint32_t disproof = 1;       // Disproof number, in the view of the attacker.
+        long long work = 0;          // Nodes searched below this state. Used for eviction and for choosing lines.
+        bool path_dependent = false; // True if the numbers count a repetition of the path as not won, so they may not hold from other paths.
+    };
+
+    class Child {
+      public:
+        MoveType move;              // Move that leads to the child.
+        StateType state;            // Transposition table key of the child.
+        bool fixed = false;         // True if the numbers of the child don't come from the transposition table.
+        bool repeated = false;      // True if the child is a state of the path.
+        uint32_t proof = 1;         // Proof number of the child, if fixed.
+        uint32_t disproof = 1;      // Disproof number of the child, if fixed.
+    };
+
+    GameType game;                                                      // Game.
+    Settings settings;                                                  // Search settings.
+    int attacker = GameType::PLAYER_MAX;                                // Player who is proven to win or not.
+    chrono::time_point<chrono::high_resolution_clock> deadline;         // Time at which the search is abandoned.
+    optional<long long> node_limit = nullopt;                           // Node at which the search is abandoned.
+    long long nodes = 0;                                                // Nodes of the current solve call.
+    bool stopped = false;                                               // True if a limit was reached.
+    unordered_set<StateType> path;                                      // States between the root and the current node.
+    unordered_map<StateType, TranspositionEntry> transposition_table[2]; // Results for PLAYER_MAX and PLAYER_MIN as the attacker.
+
+    /* Returns the index of the attacker in the transposition tables. */
+    static int get_attacker_index(int player) {
+        return player == GameType::PLAYER_MAX ? 0 : 1;
+    }
+
+    /* Adds proof or disproof numbers, keeping the result finite unless one of them is infinite. */
+    static uint32_t add(uint32_t a, uint32_t b) {
+        if (a == INFINITE_NUMBER or b == INFINITE_NUMBER) {
+            return INFINITE_NUMBER;
+        }
+
+        return static_cast<uint32_t>(min<uint64_t>(static_cast<uint64_t>(a) + b, INFINITE_NUMBER - 1));
+    }
+
+    /* Returns the transposition table key of the current state. */
+    StateType get_key() const {
+        return settings.symmetries ? game.get_canonical_state().first : game.get_state();
+    }
+
+    /* Returns the transposition table of the current attacker. */
+    unordered_map<StateType, TranspositionEntry> &get_transposition_table() {
+        return transposition_table[get_attacker_index(attacker)];
+    }
+
+    /* Returns the proof and disproof numbers of a child. */
+    pair<uint32_t, uint32_t> get_numbers(const Child &child) {
+        if (child.fixed) {
+            return {child.proof, child.disproof};
+        }
+
+        unordered_map<StateType, TranspositionEntry> &table = get_transposition_table();
+        auto it = table.find(child.state);
+        return it == table.end() ? make_pair(1u, 1u) : make_pair(it->second.proof, it->second.disproof);
+    }
+
+    /* Returns true if the numbers of a child depend on the path: it repeats a state of the path, or its entry counted such a repetition. */
+    bool is_path_dependent(const Child &child) {
+        if (child.fixed) {
+            return child.repeated;
+        }
+
+        unordered_map<StateType, TranspositionEntry> &table = get_transposition_table();
+        auto it = table.find(child.state);
+        return it != table.end() and it->second.path_dependent;
+    }
+
+    /* Removes the entries that depend on the path they were found in, so that they are not reused from another root. */
+    void forget_path_dependent_entries() {
+        unordered_map<StateType, TranspositionEntry> &table = get_transposition_table();
+
+        for (auto it = table.begin(); it != table.end();) {
+            it = it->second.path_dependent ? table.erase(it) : next(it);
+        }
+    }
+
+    /* Evicts the least searched half of the unsolved entries, and then of the solved ones if still needed. */
+    void collect_garbage() {
+        unordered_map<StateType, TranspositionEntry> &table = get_transposition_table();
+        vector<pair<bool, long long>> keys;
+        keys.reserve(table.size());
+
+        for (const auto &[state, entry] : table) {
+            keys.push_back({entry.proof == 0 or entry.disproof == 0, entry.work});
+        }
+
+        nth_element(keys.begin(), keys.begin() + keys.size() / 2, keys.end());
+        pair<bool, long long> median = keys[keys.size() / 2];
+
+        for (auto it = table.begin(); it != table.end();) {
+            pair<bool, long long> key = {it->second.proof == 0 or it->second.disproof == 0, it->second.work};
+            it = key <= median ? table.erase(it) : next(it);
+        }
+    }
+
+    /* Stores the numbers of the state with the given key. */
+    void store(const StateType &key, uint32_t proof, uint32_t disproof, long long work, bool path_dependent) {
+        unordered_map<StateType, TranspositionEntry> &table = get_transposition_table();
+
+        if (table.size() >= settings.transposition_table_capacity and table.find(key) == table.end()) {
+            collect_garbage();
+        }
+
+        TranspositionEntry &entry = table[key];
+        entry.proof = proof;
+        entry.disproof = disproof;
+        entry.work += work;
+        entry.path_dependent = path_dependent;
+    }
+
+    /* Returns the children of the current state. Finished games and repeated states get fixed numbers, repetitions counting as not won. */
+    vector<Child> get_children() {
+        const vector<MoveType> moves = game.get_moves();
+        vector<Child> children;
+        children.reserve(moves.size());
+
+        for (const MoveType &move : moves) {
+            game.make_move(move);
+            Child child{move, get_key()};
+
+            if (game.is_game_over()) {
+                child.fixed = true;
+                child.proof = game.get_winner().value() == attacker ? 0 : INFINITE_NUMBER;
+                child.disproof = game.get_winner().value() == attacker ? INFINITE_NUMBER : 0;
+            } else if (path.count(child.state)) {
+                child.fixed = true;
+                child.repeated = true;
+                child.proof = INFINITE_NUMBER;
+                child.disproof = 0;
+            }
+
+            game.rollback();
+            children.push_back(child);
+        }
+
+        return children;
+    }
+
+    /* Multiple iterative deepening: searches the current state until its numbers reach one of the thresholds. */
+    void search(uint32_t proof_threshold, uint32_t disproof_threshold) {
+        long long start_nodes = nodes++;
+
+        if (nodes % DEADLINE_CHECK_INTERVAL == 0 and chrono::high_resolution_clock::now() > deadline) {
+            stopped = true;
+        }
+
+        if (node_limit.has_value() and nodes >= node_limit.value()) {
+            stopped = true;
+        }
+
+        const bool attacking = game.get_player() == attacker;
+        const StateType key = get_key();
+        path.insert(key);
+        const vector<Child> children = get_children();
+
+        uint32_t proof, disproof;
+
+        while (true) {
+            // Attacker nodes need one proven child and all children disproven, defender nodes the opposite.
+            uint32_t best = INFINITE_NUMBER, second_best = INFINITE_NUMBER, sum = 0;
+            int best_child = 0;
+
+            for (int i = 0; i < children.size(); i++) {
+                auto [child_proof, child_disproof] = get_numbers(children[i]);
+                uint32_t minimized = attacking ? child_proof : child_disproof;
+
+                if (minimized < best) {
+                    second_best = best;
+                    best = minimized;
+                    best_child = i;
+                } else if (minimized < second_best) {
+                    second_best = minimized;
+                }
+
+                sum = add(sum, attacking ? child_disproof : child_proof);
+            }
+
+            proof = attacking ? best : sum;
+            disproof = attacking ? sum : best;
+
+            if (stopped or proof >= proof_threshold or disproof >= disproof_threshold) {
+                break;
+            }
+
+            // Searching the most proving child until it stops being the best one by a margin.
+            auto [child_proof, child_disproof] = get_numbers(children[best_child]);
+            uint32_t child_proof_threshold, child_disproof_threshold;
+
+            if (attacking) {
+                child_proof_threshold = min(proof_threshold, add(second_best, 1));
+                child_disproof_threshold = add(disproof_threshold - disproof, child_disproof);
+            } else {
+                child_proof_threshold = add(proof_threshold - proof, child_proof);
+                child_disproof_threshold = min(disproof_threshold, add(second_best, 1));
+            }
+
+            game.make_move(children[best_child].move);
+            search(child_proof_threshold, child_disproof_threshold);
+            game.rollback();
+        }
+
+        // Numbers that count a repetition of the path are marked, since they may not hold when the state is reached from another path.
+        bool path_dependent = false;
+
+        for (const Child &child : children) {
+            path_dependent = path_dependent or is_path_dependent(child);
+        }
+
+        path.erase(key);
+        store(key, proof, disproof, nodes - start_nodes, path_dependent);
+    }
+
+    /* Returns the entry of the current state, if any. */
+    const TranspositionEntry *probe() {
+        unordered_map<StateType, TranspositionEntry> &table = get_transposition_table();
+        auto it = table.find(get_key());
+        return it == table.end() ? nullptr : &it->second;
+    }
+
+    /* Returns the child that the player to move chooses in a solved state: a winning child taking the least work, or else the child taking the most. */
+    optional<Child> choose_child(const vector<Child> &children) {
+        const bool attacking = game.get_player() == attacker;
+        const TranspositionEntry *entry = probe();
+
+        if (entry == nullptr or (entry->proof != 0 and entry->disproof != 0)) {
+            return nullopt;
+        }
+
+        // The player to move wins if it is the attacker and the state is proven, or the defender and the state is disproven.
+        const bool winning = attacking == (entry->proof == 0);
+        optional<Child> ans = nullopt;
+        long long ans_work = 0;
+
+        for (const Child &child : children) {
+            auto [child_proof, child_disproof] = get_numbers(child);
+            bool child_winning = attacking ? child_proof == 0 : child_disproof == 0;
+
+            if (winning and !child_winning) {
+                continue;
+            }
+
+            long long work = 0;
+
+            if (!child.fixed) {
+                auto it = get_transposition_table().find(child.state);
+                work = it == get_transposition_table().end() ? 0 : it->second.work;
+            }
+
+            if (!ans.has_value() or (winning ? work < ans_work : work > ans_work)) {
+                ans = child;
+                ans_work = work;
+            }
+        }
+
+        return ans;
+    }
+
+    /* Returns the solved line from the current state. */
+    vector<MoveType> get_principal_variation() {
+        vector<MoveType> principal_variation;
+        unordered_set<StateType> visited;
+
+        while (!game.is_game_over() and visited.insert(get_key()).second) {
+            path = visited;
+            optional<Child> child = choose_child(get_children());
+
+            if (!child.has_value()) {
+                break;
+            }
+
+            principal_variation.push_back(child->move);
+            game.make_move(child->move);
+        }
+
+        for (int i = 0; i < principal_variation.size(); i++) {
+            game.rollback();
+        }
+
+        path.clear();
+        return principal_variation;
+    }
+
+    /* Counts the distinct states of the proof tree below the current state: one winning child where the player to move wins, every child otherwise. */
+    long long get_proof_tree_size() {
+        unordered_set<StateType> visited = {get_key()};
+        vector<vector<MoveType>> stack = {{}};
+
+        while (!stack.empty()) {
+            vector<MoveType> line = stack.back();
+            stack.pop_back();
+
+            for (const MoveType &move : line) {
+                game.make_move(move);
+            }
+
+            if (!game.is_game_over()) {
+                const bool attacking = game.get_player() == attacker;
+                const TranspositionEntry *entry = probe();
+                const bool winning = entry != nullptr and attacking == (entry->proof == 0);
+                vector<Child> children = get_children();
+
+                if (winning) {
+                    optional<Child> child = choose_child(children);
+                    children = child.has_value() ? vector<Child>{child.value()} : vector<Child>();
+                }
+
+                for (const Child &child : children) {
+                    if (visited.insert(child.state).second) {
+                        stack.push_back(line);
+                        stack.back().push_back(child.move);
+                    }
+                }
+            }
+
+            for (int i = 0; i < line.size(); i++) {
+                game.rollback();
+            }
+        }
+
+        return visited.size();
+    }
+
+    /* Proves or disproves that the attacker wins from the current state. Returns nullopt if a limit was reached. */
+    optional<bool> prove(int attacker_) {
+        attacker = attacker_;
+        path.clear();
+        forget_path_dependent_entries();
+        search(INFINITE_NUMBER, INFINITE_NUMBER);
+
+        const TranspositionEntry *entry = probe();
+
+        if (entry == nullptr or (entry->proof != 0 and entry->disproof != 0)) {
+            return nullopt;
+        }
+
+        return entry->proof == 0;
+    }
+
+  public:
+    ProofNumber() = default;
+    ProofNumber(const Settings &settings_) : settings(settings_) {}
+    ~ProofNumber() = default;
+
+    /* Forgets everything learned by previous calls. */
+    void clear() {
+        transposition_table[0].clear();
+        transposition_table[1].clear();
+    }
+
+    /* Solves the game within the given limits. A player wins if it is proven to win, and the game is a draw if neither player does, which in games
+       with cycles means that the defender can repeat states forever. Results that count a repetition depend on the path they were found in (the
+       graph history interaction problem): they are only reused within the search of the same root and player, and forgotten before the next one.
+       Within a search they can still be reused from another path, as in plain df-pn, so draws and wins in games with cycles (MuTorere, BaghChal)
+       are not guaranteed to be exact. Results without repetitions are kept between calls. */
+    Result solve(const GameType &game_, const Limits &limits) {
+        Result result;
+        game = game_;
+        nodes = 0;
+        stopped = false;
+        node_limit = limits.nodes;
+
+        if (limits.timeout.has_value()) {
+            deadline = chrono::high_resolution_clock::now() + chrono::duration_cast<chrono::high_resolution_clock::duration>(limits.timeout.value());
+        } else {
+            deadline = chrono::time_point<chrono::high_resolution_clock>::max();
+        }
+
+        if (game.is_game_over()) {
+            result.winner = game.get_winner();
+            result.proof_tree_size = 1;
+            return result;
+        }
+
+        // The player to move first, since its proof also decides the move.
+        for (int player : {game.get_player(), game.get_enemy()}) {
+            optional<bool> proven = prove(player);
+
+            if (!proven.has_value()) {
+                result.nodes = nodes;
+                return result;
+            }
+
+            if (proven.value() or player == game.get_enemy()) {
+                result.winner = proven.value() ? player : GameType::PLAYER_NONE;
+                break;
+            }
+        }
+
+        result.principal_variation = get_principal_variation();
+        result.proof_tree_size = get_proof_tree_size();
+        result.nodes = nodes;
+        return result;
+    }
+
+    /* Returns the best move obtained with proof-number search given a time limit. */
+    pair<OptimalMove, int> get_move(const GameType &game_, chrono::duration<long double> timeout) {
+        Limits limits;
+        limits.timeout = timeout;
+        return get_move(game_, limits);
+    }
+
+    /* Returns the best move obtained with proof-number search within the given limits. Unsolved states get the most proving move. */
+    pair<OptimalMove, int> get_move(const GameType &game_, const Limits &limits) {
+        Result result = solve(game_, limits);
+        OptimalMove ans;
+
+        if (result.winner.has_value() and !result.principal_variation.empty()) {
+            int turn = game_.get_turn() + result.principal_variation.size();
+            ans = OptimalMove(result.principal_variation[0], Minimax<GameType>::terminal_score(result.winner.value(), turn), result.winner, turn);
+            return {ans, static_cast<int>(result.principal_variation.size())};
+        }
+
+        // Most proving move of the player to move.
+        game = game_;
+        attacker = game.get_player();
+        uint32_t best_proof = INFINITE_NUMBER;
+
+        for (const Child &child : get_children()) {
+            auto [child_proof, child_disproof] = get_numbers(child);
+
+            if (ans.turn == -1 or (child_proof < best_proof and child_disproof != 0)) {
+                ans = OptimalMove(child.move, 0, nullopt, game.get_turn() + 1);
+                best_proof = child_proof;
+            }
+        }
+
+        return {ans, 0};
+    }
+};
\ No newline at end of file
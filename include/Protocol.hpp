@@ -0,0 +1,337 @@
+#pragma once
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Game.hpp>
+#include <Minimax.hpp>
+
+#include <BaghChalGame.hpp>
+#include <ConnectFourGame.hpp>
+#include <KonaneGame.hpp>
+#include <MuTorereGame.hpp>
+#include <TicTacToeGame.hpp>
+
+using namespace std;
+
+/* Line based engine protocol over stdin and stdout, for running the engine behind other programs. Commands:
+     newgame <game>              Starts a game of Konane, MuTorere, BaghChal, TicTacToe or ConnectFour.
+     position startpos           Goes back to the start of the game.
+     position <serialized state> Sets the position.
+     play <move>[, <move>...]    Plays moves, written as the numbers typed in the game (e.g. "play 0 0 2 0, 5 5").
+     go [time <seconds>] [depth <plies>] [nodes <n>]
+                                 Searches on a worker thread, printing "info" after every depth and then "bestmove <move>".
+                                 Searches until the game is solved if there are no limits.
+     stop                        Stops the search, which prints its best move so far.
+     state                       Prints the serialized state.
+     isready                     Prints "readyok".
+     quit                        Stops the search and exits.
+   Errors are printed as "error <message>". Only stop, isready and quit are accepted while searching. */
+class Protocol {
+  private:
+    /* Limits of a go command. */
+    class SearchLimits {
+      public:
+        optional<double> time = nullopt;
+        optional<int> depth = nullopt;
+        optional<long long> nodes = nullopt;
+    };
+
+    /* Game being played, with an engine that keeps what it learned between searches. */
+    class Session {
+      public:
+        virtual ~Session() = default;
+
+        /* Sets the position. Returns false if the state can't be read. */
+        virtual bool set_position(const optional<string> &serialized_state) = 0;
+
+        /* Plays a move. Returns false if it is not valid. */
+        virtual bool play(const string &move) = 0;
+
+        /* Returns the serialized state. */
+        virtual string get_state() const = 0;
+
+        /* Searches the position, printing its progress. Returns the best move. */
+        virtual string go(const SearchLimits &, const atomic<bool> &stop, Protocol &protocol) = 0;
+    };
+
+    template <class GameType> class GameSession : public Session {
+      private:
+        using StateType = typename GameType::state_type;
+        using MoveType = typename GameType::move_type;
+
+        GameType game;
+        Minimax<GameType> ai;
+
+      public:
+        bool set_position(const optional<string> &serialized_state) override {
+            if (!serialized_state.has_value()) {
+                game = GameType();
+                return true;
+            }
+
+            try {
+                game = GameType(StateType::deserialize(serialized_state.value()));
+            } catch (const exception &) {
+                return false;
+            }
+
+            return true;
+        }
+
+        bool play(const string &move) override {
+            optional<MoveType> m = game.is_game_over() ? nullopt : game.get_player_move(move);
+
+            if (!m.has_value()) {
+                return false;
+            }
+
+            game.make_move(m.value());
+            return true;
+        }
+
+        string get_state() const override {
+            return game.get_state().serialize();
+        }
+
+        string go(const SearchLimits &search_limits, const atomic<bool> &stop, Protocol &protocol) override {
+            if (game.is_game_over()) {
+                return "none";
+            }
+
+            typename Minimax<GameType>::Limits limits;
+            limits.depth = search_limits.depth;
+            limits.nodes = search_limits.nodes;
+            limits.stop = &stop;
+
+            if (search_limits.time.has_value()) {
+                limits.timeout = chrono::duration<long double>(search_limits.time.value());
+            }
+
+            auto result = ai.get_move(game, limits, [&](const typename Minimax<GameType>::Progress &progress) {
+                string principal_variation;
+
+                for (const MoveType &move : progress.principal_variation) {
+                    principal_variation += (principal_variation.empty() ? "" : ", ") + get_move_command(move);
+                }
+
+                char buffer[256];
+                snprintf(buffer, sizeof(buffer), "info depth %d score %.6lf%s nodes %lld nps %.0lf time %.3lf pv ", progress.depth,
+                         progress.ans.evaluation(), get_winner_text(progress.ans.winner).c_str(), progress.nodes,
+                         progress.time > 0.0 ? progress.nodes / progress.time : 0.0, progress.time);
+                protocol.print(buffer + principal_variation);
+            });
+
+            return get_move_command(get<0>(result).move);
+        }
+    };
+
+    unique_ptr<Session> session;     // Current game, if any.
+    thread worker;                   // Thread of the current or last search.
+    atomic<bool> searching = false;  // True while the worker is searching.
+    atomic<bool> stop = false;       // Stops the current search.
+    mutex output_mutex;              // Lines printed by both threads don't mix.
+
+    /* Returns a move as the numbers typed to play it, which are the numbers of its text in the same order. */
+    static string get_move_command(const GameMove &move) {
+        string command;
+        bool in_number = false;
+
+        for (char c : string(move)) {
+            if (isdigit(c) and !in_number and !command.empty()) {
+                command += ' ';
+            }
+
+            if (isdigit(c)) {
+                command += c;
+            }
+
+            in_number = isdigit(c);
+        }
+
+        return command;
+    }
+
+    /* Returns the winner of a solved line as text. */
+    static string get_winner_text(const optional<int> &winner) {
+        if (!winner.has_value()) {
+            return "";
+        }
+
+        return winner.value() == 0 ? " solved draw" : (winner.value() > 0 ? " solved max" : " solved min");
+    }
+
+    /* Returns the session of a new game, or nullptr if there is no such game. */
+    static unique_ptr<Session> create_session(const string &game_name) {
+        if (game_name == "Konane") {
+            return make_unique<GameSession<KonaneGame>>();
+        } else if (game_name == "MuTorere") {
+            return make_unique<GameSession<MuTorereGame>>();
+        } else if (game_name == "BaghChal") {
+            return make_unique<GameSession<BaghChalGame>>();
+        } else if (game_name == "TicTacToe") {
+            return make_unique<GameSession<TicTacToeGame>>();
+        } else if (game_name == "ConnectFour") {
+            return make_unique<GameSession<ConnectFourGame>>();
+        }
+
+        return nullptr;
+    }
+
+    /* Waits for the last search to end. */
+    void join() {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    /* Parses the limits of a go command. Returns nullopt if they are not valid. */
+    static optional<SearchLimits> parse_limits(istringstream &arguments) {
+        SearchLimits limits;
+        string name;
+
+        while (arguments >> name) {
+            if (name == "time" and arguments >> limits.time.emplace()) {
+                continue;
+            } else if (name == "depth" and arguments >> limits.depth.emplace()) {
+                continue;
+            } else if (name == "nodes" and arguments >> limits.nodes.emplace()) {
+                continue;
+            }
+
+            return nullopt;
+        }
+
+        return limits;
+    }
+
+    /* Handles a command. Returns false if it was quit. */
+    bool handle(const string &line) {
+        istringstream arguments(line);
+        string command, rest;
+        arguments >> command;
+        getline(arguments >> ws, rest);
+
+        if (command.empty()) {
+            return true;
+        }
+
+        if (command == "quit") {
+            stop = true;
+            join();
+            return false;
+        }
+
+        if (command == "isready") {
+            print("readyok");
+            return true;
+        }
+
+        if (command == "stop") {
+            stop = true;
+            return true;
+        }
+
+        if (searching) {
+            print("error searching");
+            return true;
+        }
+
+        join();
+
+        if (command == "newgame") {
+            unique_ptr<Session> new_session = create_session(rest);
+
+            if (new_session == nullptr) {
+                print("error unknown game " + rest);
+            } else {
+                session = move(new_session);
+            }
+
+            return true;
+        }
+
+        if (session == nullptr) {
+            print("error no game");
+            return true;
+        }
+
+        if (command == "position") {
+            if (!session->set_position(rest == "startpos" ? nullopt : optional<string>(rest))) {
+                print("error invalid state " + rest);
+            }
+        } else if (command == "play") {
+            istringstream moves(rest);
+            string move;
+
+            while (getline(moves >> ws, move, ',')) {
+                if (!session->play(move)) {
+                    print("error invalid move " + move);
+                    break;
+                }
+            }
+        } else if (command == "go") {
+            istringstream limit_arguments(rest);
+            optional<SearchLimits> limits = parse_limits(limit_arguments);
+
+            if (!limits.has_value()) {
+                print("error invalid limits " + rest);
+                return true;
+            }
+
+            stop = false;
+            searching = true;
+            worker = thread([this, limits]() {
+                string best_move = session->go(limits.value(), stop, *this);
+
+                // Commands that follow bestmove must not see the search running.
+                searching = false;
+                print("bestmove " + best_move);
+            });
+        } else if (command == "state") {
+            print("state " + session->get_state());
+        } else {
+            print("error unknown command " + command);
+        }
+
+        return true;
+    }
+
+  public:
+    ~Protocol() {
+        stop = true;
+        join();
+    }
+
+    /* Prints a line. Safe to call from the worker. */
+    void print(const string &line) {
+        lock_guard<mutex> lock(output_mutex);
+        fputs((line + "\n").c_str(), stdout);
+        fflush(stdout);
+    }
+
+    /* Reads commands until quit or the end of the input. */
+    void run() {
+        string line;
+
+        while (getline(cin, line)) {
+            if (!line.empty() and line.back() == '\r') {
+                line.pop_back();
+            }
+
+            if (!handle(line)) {
+                return;
+            }
+        }
+    }
+};
\ No newline at end of file
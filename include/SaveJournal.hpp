@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/* Saves of every turn of a match in a single binary file: a header followed by one fixed size record per turn, so that the record of turn t is at
+   a known offset. Records are appended to one open file instead of creating a file per turn, and undoing moves discards the records after the turn
+   that is saved again. */
+class SaveJournal {
+  public:
+    /* Maximum length of a serialized state. */
+    static constexpr int STATE_CAPACITY = 120;
+
+    /* Value of Record::move_index when the state was not reached with a move (first turn of a match or loaded game). */
+    static constexpr int16_t NO_MOVE = -1;
+
+    class Settings {
+      public:
+        int sync_interval = 0; // Records between two fsync calls, or 0 to leave syncing to the operating system.
+    };
+
+    class Record {
+      public:
+        int32_t turn = 0;                // Turn of the state, starting from 1.
+        int16_t move_index = NO_MOVE;    // Index in Game::get_moves of the previous state of the move that led to this state.
+        uint16_t state_length = 0;       // Length of the serialized state.
+        char state[STATE_CAPACITY] = {}; // Serialized state.
+
+        /* Returns the serialized state. */
+        string get_state() const {
+            return string(state, state_length);
+        }
+    };
+
+  private:
+    /* File header. */
+    static constexpr char MAGIC[4] = {'M', 'M', 'S', 'J'};
+    static constexpr int32_t VERSION = 1;
+    static constexpr long HEADER_SIZE = sizeof(MAGIC) + 2 * sizeof(int32_t);
+
+    Settings settings;    // Journal settings.
+    FILE *file = nullptr; // Journal being written, if any.
+    string path;          // Path of the journal being written.
+    int records = 0;      // Records in the file.
+    int unsynced = 0;     // Records appended since the last fsync.
+
+    /* Returns the offset of the record of a turn. */
+    static long get_offset(int turn) {
+        return HEADER_SIZE + static_cast<long>(turn - 1) * sizeof(Record);
+    }
+
+  public:
+    SaveJournal() = default;
+    SaveJournal(const Settings &settings_) : settings(settings_) {}
+    SaveJournal(const SaveJournal &) = delete;
+    SaveJournal &operator=(const SaveJournal &) = delete;
+
+    ~SaveJournal() {
+        close();
+    }
+
+    /* Starts an empty journal, replacing the file if it exists. Returns false if it can't be created. */
+    bool create(const filesystem::path &path_) {
+        close();
+        error_code error;
+        filesystem::create_directories(path_.parent_path(), error);
+        file = fopen(path_.string().c_str(), "w+b");
+
+        if (file == nullptr) {
+            return false;
+        }
+
+        path = path_.string();
+        records = unsynced = 0;
+
+        int32_t header[2] = {VERSION, static_cast<int32_t>(sizeof(Record))};
+        bool valid = fwrite(MAGIC, sizeof(MAGIC), 1, file) == 1 and fwrite(header, sizeof(header), 1, file) == 1 and fflush(file) == 0;
+
+        if (!valid) {
+            close();
+        }
+
+        return valid;
+    }
+
+    /* Saves the state of a turn. A turn that was already saved discards its record and the ones after it. Returns false if it can't be written. */
+    bool append(int turn, const string &serialized_state, int move_index = NO_MOVE) {
+        if (file == nullptr or turn < 1 or turn > records + 1 or serialized_state.size() > STATE_CAPACITY) {
+            return false;
+        }
+
+        // Undone turns.
+        if (turn <= records) {
+            if (fflush(file) != 0) {
+                return false;
+            }
+
+            error_code error;
+            filesystem::resize_file(path, get_offset(turn), error);
+
+            if (error) {
+                return false;
+            }
+
+            records = turn - 1;
+        }
+
+        Record record;
+        record.turn = turn;
+        record.move_index = move_index;
+        record.state_length = serialized_state.size();
+        memcpy(record.state, serialized_state.data(), serialized_state.size());
+
+        if (fseek(file, get_offset(turn), SEEK_SET) != 0 or fwrite(&record, sizeof(record), 1, file) != 1 or fflush(file) != 0) {
+            return false;
+        }
+
+        records = turn;
+
+        if (settings.sync_interval > 0 and ++unsynced >= settings.sync_interval) {
+            unsynced = 0;
+#ifdef _WIN32
+            return _commit(_fileno(file)) == 0;
+#else
+            return fsync(fileno(file)) == 0;
+#endif
+        }
+
+        return true;
+    }
+
+    /* Closes the file. */
+    void close() {
+        if (file != nullptr) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    /* Returns the record of a turn from a journal file, if it was saved. Reads only the header and that record. */
+    static optional<Record> read(const filesystem::path &path_, int turn) {
+        if (turn < 1) {
+            return nullopt;
+        }
+
+        FILE *input = fopen(path_.string().c_str(), "rb");
+
+        if (input == nullptr) {
+            return nullopt;
+        }
+
+        char magic[4];
+        int32_t header[2];
+        Record record;
+        bool valid = fread(magic, sizeof(magic), 1, input) == 1 and fread(header, sizeof(header), 1, input) == 1 and
+                     memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 and header[0] == VERSION and header[1] == sizeof(Record) and
+                     fseek(input, get_offset(turn), SEEK_SET) == 0 and fread(&record, sizeof(record), 1, input) == 1;
+        fclose(input);
+
+        if (!valid or record.turn != turn or record.state_length > STATE_CAPACITY) {
+            return nullopt;
+        }
+
+        return record;
+    }
+};
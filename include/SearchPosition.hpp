@@ -0,0 +1,106 @@
+#pragma once
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/* Position searched by Minimax. Instead of copying the match with every state and move list played so far, it starts a game from the current state
+   of the match and keeps the hashes of the states since then, which is all that repetitions need. Setting it up and its memory depend on the depth
+   of the search, not on the length of the match. Turns are still counted from the start of the match. */
+template <class GameType> class SearchPosition {
+  public:
+    using StateType = typename GameType::state_type;
+    using MoveType = typename GameType::move_type;
+
+  private:
+    GameType game;         // Game started from the root of the search.
+    int root_turn = 1;     // Turn of the match in which the search starts.
+    vector<size_t> hashes; // Hashes of the states from the root to the current one.
+
+  public:
+    SearchPosition() : hashes{game.get_state().hash()} {}
+
+    explicit SearchPosition(const GameType &game_) : game(game_.get_state()), root_turn(game_.get_turn()), hashes{game_.get_state().hash()} {}
+
+    /* Performs a move. Assumes that is_valid_move(m) is true. */
+    void make_move(const MoveType &m) {
+        game.make_move(m);
+        hashes.push_back(game.get_state().hash());
+    }
+
+    /* Undoes the last move. Does nothing in the root. */
+    void rollback() {
+        if (hashes.size() > 1) {
+            game.rollback();
+            hashes.pop_back();
+        }
+    }
+
+    /* Returns true if the current state was already reached since the root. Players alternate, so only every other state can be the same one. States
+       are told apart by their hash only. */
+    bool is_repetition() const {
+        for (int i = static_cast<int>(hashes.size()) - 3; i >= 0; i -= 2) {
+            if (hashes[i] == hashes.back()) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /* Returns the turn number, counted from the start of the match. */
+    int get_turn() const {
+        return root_turn + game.get_turn() - 1;
+    }
+
+    /* Same as the Game functions. */
+    int get_player() const {
+        return game.get_player();
+    }
+
+    int get_enemy() const {
+        return game.get_enemy();
+    }
+
+    const StateType &get_state() const {
+        return game.get_state();
+    }
+
+    const vector<MoveType> &get_moves() const {
+        return game.get_moves();
+    }
+
+    bool is_valid_move(const MoveType &m) const {
+        return game.is_valid_move(m);
+    }
+
+    bool is_game_over() const {
+        return game.is_game_over();
+    }
+
+    optional<int> get_winner() const {
+        return game.get_winner();
+    }
+
+    double evaluate() const {
+        return game.evaluate();
+    }
+
+    pair<StateType, int> get_canonical_state() const {
+        return game.get_canonical_state();
+    }
+
+    MoveType get_symmetric_move(const MoveType &m, int symmetry) const {
+        return game.get_symmetric_move(m, symmetry);
+    }
+
+    bool is_forcing_move(const MoveType &m) const {
+        return game.is_forcing_move(m);
+    }
+
+    vector<MoveType> get_noisy_moves() const {
+        return game.get_noisy_moves();
+    }
+};
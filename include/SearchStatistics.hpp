@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/* Set SEARCH_STATISTICS to 0 to compile the collection of search statistics out. Node counts are always kept, since searches need them. */
+#ifndef SEARCH_STATISTICS
+#define SEARCH_STATISTICS 1
+#endif
+
+using namespace std;
+
+/* What a search did. Filled during Minimax::solve and returned by Minimax::get_move. Depths are distances from the root. */
+class SearchStatistics {
+  public:
+    class Depth {
+      public:
+        long long nodes = 0;              // Nodes at this depth.
+        long long leaf_nodes = 0;         // Nodes evaluated or in which the game is over.
+        long long cutoffs = 0;            // Nodes in which alpha-beta pruning skipped the remaining moves.
+        long long first_move_cutoffs = 0; // Cutoffs caused by the first move searched.
+    };
+
+    class Iteration {
+      public:
+        int depth = 0;          // Depth searched.
+        long long nodes = 0;    // Nodes searched.
+        double time = 0.0;      // Seconds spent.
+        bool completed = false; // False if the iteration was abandoned at the deadline.
+        double score = 0.0;     // Evaluation of the best move in [-1, +1], if completed.
+    };
+
+    long long nodes = 0;                      // Nodes searched.
+    long long transposition_table_probes = 0; // Transposition table lookups.
+    long long transposition_table_hits = 0;   // Transposition table lookups that found an entry.
+    long long multi_pv_nodes = 0;             // Nodes spent finding the root moves after the best one, with Minimax::Settings::multi_pv > 1.
+    vector<Depth> depths;                     // Statistics of every depth, summed over iterations.
+    vector<Iteration> iterations;             // Iterations of iterative deepening.
+
+    /* Records a node at the given depth. */
+    void add_node([[maybe_unused]] int depth, [[maybe_unused]] bool leaf) {
+#if SEARCH_STATISTICS
+        if (depth >= depths.size()) {
+            depths.resize(depth + 1);
+        }
+
+        depths[depth].nodes++;
+        depths[depth].leaf_nodes += leaf;
+#endif
+    }
+
+    /* Records a cutoff at the given depth, caused by the move searched in the given position. */
+    void add_cutoff([[maybe_unused]] int depth, [[maybe_unused]] int move_index) {
+#if SEARCH_STATISTICS
+        depths[depth].cutoffs++;
+        depths[depth].first_move_cutoffs += move_index == 0;
+#endif
+    }
+
+    /* Records a transposition table lookup. */
+    void add_probe([[maybe_unused]] bool hit) {
+#if SEARCH_STATISTICS
+        transposition_table_probes++;
+        transposition_table_hits += hit;
+#endif
+    }
+
+    /* Records an iteration of iterative deepening. */
+    void add_iteration([[maybe_unused]] const Iteration &iteration) {
+#if SEARCH_STATISTICS
+        iterations.push_back(iteration);
+#endif
+    }
+
+    /* Returns the total of a field of every depth. */
+    long long sum(long long Depth::*field) const {
+        long long ans = 0;
+
+        for (const Depth &depth : depths) {
+            ans += depth.*field;
+        }
+
+        return ans;
+    }
+
+    /* Returns the percentage of cutoffs caused by the first move searched, which measures move ordering. */
+    double first_move_cutoff_percentage() const {
+        long long cutoffs = sum(&Depth::cutoffs);
+        return cutoffs > 0 ? 100.0 * sum(&Depth::first_move_cutoffs) / cutoffs : 0.0;
+    }
+
+    /* Returns the percentage of transposition table lookups that found an entry. */
+    double transposition_table_hit_percentage() const {
+        return transposition_table_probes > 0 ? 100.0 * transposition_table_hits / transposition_table_probes : 0.0;
+    }
+
+    /* Returns the ratio between the nodes of the last two completed iterations, or 0 if there are not two. */
+    double effective_branching_factor() const {
+        const Iteration *last = nullptr, *previous = nullptr;
+
+        for (const Iteration &iteration : iterations) {
+            if (iteration.completed) {
+                previous = last;
+                last = &iteration;
+            }
+        }
+
+        return last != nullptr and previous != nullptr and previous->nodes > 0 ? static_cast<double>(last->nodes) / previous->nodes : 0.0;
+    }
+
+    /* Returns how much the score went back and forth between completed iterations: the sum of its changes minus its net change. Zero if it only
+       moved in one direction, which measures how stable the search is. */
+    double score_oscillation() const {
+        const Iteration *first = nullptr, *previous = nullptr;
+        double change = 0.0;
+
+        for (const Iteration &iteration : iterations) {
+            if (!iteration.completed) {
+                continue;
+            }
+
+            if (previous != nullptr) {
+                change += abs(iteration.score - previous->score);
+            } else {
+                first = &iteration;
+            }
+
+            previous = &iteration;
+        }
+
+        return previous != nullptr ? change - abs(previous->score - first->score) : 0.0;
+    }
+
+    /* Returns a one line summary. */
+    string summary() const {
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer), "nodes = %lld / leaves = %lld / cutoffs = %lld (%.1lf%% first move) / TT hits = %.1lf%% / EBF = %.2lf", nodes,
+                 sum(&Depth::leaf_nodes), sum(&Depth::cutoffs), first_move_cutoff_percentage(), transposition_table_hit_percentage(),
+                 effective_branching_factor());
+        string ans = buffer;
+
+        if (multi_pv_nodes > 0) {
+            snprintf(buffer, sizeof(buffer), " / multi-PV = %.1lf%% of nodes", nodes > 0 ? 100.0 * multi_pv_nodes / nodes : 0.0);
+            ans += buffer;
+        }
+
+        return ans;
+    }
+
+    /* Returns the statistics as a single line JSON object. */
+    string to_json() const {
+        char buffer[256];
+        string json;
+
+        snprintf(buffer, sizeof(buffer),
+                 "{\"nodes\": %lld, \"leaf_nodes\": %lld, \"cutoffs\": %lld, \"first_move_cutoff_percentage\": %.3lf, \"tt_probes\": %lld, \"tt_hits\": %lld, ",
+                 nodes, sum(&Depth::leaf_nodes), sum(&Depth::cutoffs), first_move_cutoff_percentage(), transposition_table_probes, transposition_table_hits);
+        json += buffer;
+        snprintf(buffer, sizeof(buffer), "\"multi_pv_nodes\": %lld, ", multi_pv_nodes);
+        json += buffer;
+        snprintf(buffer, sizeof(buffer), "\"effective_branching_factor\": %.3lf, \"score_oscillation\": %.6lf, \"depths\": [", effective_branching_factor(),
+                 score_oscillation());
+        json += buffer;
+
+        for (int i = 0; i < depths.size(); i++) {
+            snprintf(buffer, sizeof(buffer), "%s{\"depth\": %d, \"nodes\": %lld, \"leaf_nodes\": %lld, \"cutoffs\": %lld, \"first_move_cutoffs\": %lld}",
+                     i > 0 ? ", " : "", i, depths[i].nodes, depths[i].leaf_nodes, depths[i].cutoffs, depths[i].first_move_cutoffs);
+            json += buffer;
+        }
+
+        json += "], \"iterations\": [";
+
+        for (int i = 0; i < iterations.size(); i++) {
+            snprintf(buffer, sizeof(buffer), "%s{\"depth\": %d, \"nodes\": %lld, \"time\": %.6lf, \"completed\": %s, \"score\": %.6lf}", i > 0 ? ", " : "",
+                     iterations[i].depth, iterations[i].nodes, iterations[i].time, iterations[i].completed ? "true" : "false", iterations[i].score);
+            json += buffer;
+        }
+
+        return json + "]}";
+    }
+};
\ No newline at end of file
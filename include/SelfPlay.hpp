@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Game.hpp>
+#include <Minimax.hpp>
+
+using namespace std;
+
+/* Games of the engine against itself, used to fit evaluations to game results. */
+template <class GameType> class SelfPlay {
+  public:
+    using StateType = typename GameType::state_type;
+    using MoveType = typename GameType::move_type;
+
+    class Settings {
+      public:
+        int games = 1000;                                         // Number of games.
+        int depth = 4;                                            // Minimax depth of every move.
+        int random_plies = 8;                                     // Random moves at the start of every game, so that games differ.
+        int multi_pv = 1;                                         // Later moves are picked at random among this many best moves...
+        double multi_pv_margin = 0.05;                            // ...that evaluate at most this much worse than the best one.
+        int max_turns = 200;                                      // Games longer than this are draws.
+        int threads = max(1u, thread::hardware_concurrency());    // Games played at the same time.
+        unsigned int seed = 0;                                    // Seed of the random moves.
+    };
+
+    /* Position with the result of its game for PLAYER_MAX: 1, 0.5 or 0. */
+    class Position {
+      public:
+        string state;
+        double result;
+    };
+
+    /* Plays the games. Returns every position after the random opening with the result of its game, sorted by state. */
+    static vector<Position> play(const Settings &settings) {
+        typename Minimax<GameType>::Settings search_settings;
+        typename Minimax<GameType>::Limits limits;
+        search_settings.multi_pv = settings.multi_pv;
+        limits.depth = settings.depth;
+
+        vector<Position> positions;
+        atomic<int> next_game = 0;
+        mutex positions_mutex;
+
+        auto worker = [&]() {
+            Minimax<GameType> ai(search_settings);
+
+            for (int game_index = next_game++; game_index < settings.games; game_index = next_game++) {
+                mt19937 rng(settings.seed + game_index);
+                GameType game;
+                vector<string> states;
+                ai.clear();
+
+                for (int turn = 0; turn < settings.max_turns and !game.is_game_over(); turn++) {
+                    const vector<MoveType> moves = game.get_moves();
+
+                    if (turn < settings.random_plies) {
+                        game.make_move(moves[uniform_int_distribution<int>(0, moves.size() - 1)(rng)]);
+                    } else {
+                        states.push_back(game.get_state().serialize());
+                        MoveType move = get<0>(ai.get_move(game, limits)).move;
+                        const auto &lines = ai.get_lines();
+
+                        // Picking any of the moves close to the best one, so that games keep differing after the random opening.
+                        if (lines.size() > 1) {
+                            int close = 1;
+
+                            while (close < lines.size() and lines[0].ans.evaluation() - lines[close].ans.evaluation() <= settings.multi_pv_margin and
+                                   lines[close].ans.evaluation() - lines[0].ans.evaluation() <= settings.multi_pv_margin) {
+                                close++;
+                            }
+
+                            move = lines[uniform_int_distribution<int>(0, close - 1)(rng)].ans.move;
+                        }
+
+                        game.make_move(move);
+                    }
+                }
+
+                // Games that reach the turn limit are draws.
+                double result = 0.5;
+
+                if (game.is_game_over()) {
+                    result = (1.0 + game.get_winner().value()) / 2.0;
+                }
+
+                lock_guard<mutex> lock(positions_mutex);
+
+                for (const string &state : states) {
+                    positions.push_back({state, result});
+                }
+            }
+        };
+
+        vector<thread> threads;
+
+        for (int i = 0; i < settings.threads; i++) {
+            threads.emplace_back(worker);
+        }
+
+        for (thread &t : threads) {
+            t.join();
+        }
+
+        // Threads finish their games in any order.
+        sort(positions.begin(), positions.end(), [](const Position &a, const Position &b) { return a.state < b.state; });
+        return positions;
+    }
+
+    /* Loads positions saved as "result state" lines. */
+    static vector<Position> load(const string &path) {
+        vector<Position> positions;
+        ifstream file(path);
+        string line;
+
+        while (getline(file, line)) {
+            istringstream line_stream(line);
+            Position position;
+
+            if (line_stream >> position.result >> position.state) {
+                positions.push_back(position);
+            }
+        }
+
+        return positions;
+    }
+
+    /* Saves positions as "result state" lines. Returns false if the file can't be written. */
+    static bool save(const string &path, const vector<Position> &positions) {
+        FILE *file = fopen(path.c_str(), "w");
+
+        if (file == nullptr) {
+            return false;
+        }
+
+        for (const Position &position : positions) {
+            fprintf(file, "%g %s\n", position.result, position.state.c_str());
+        }
+
+        fclose(file);
+        return true;
+    }
+};
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 
+#include <BoardLines.hpp>
+#include <BoardSymmetries.hpp>
 #include <Game.hpp>
 
 class TicTacToeCell {
@@ -34,19 +36,29 @@ class TicTacToeMove : public GameMove {
     TicTacToeMove(TicTacToeCell c_) : c(c_) {}
     TicTacToeMove(int x_, int y_) : TicTacToeMove(TicTacToeCell(x_, y_)) {}
 
+    bool operator==(const TicTacToeMove &m) const {
+        return c == m.c;
+    }
+
     operator string() const override {
         return string(c);
     }
 };
 
+template <> struct std::hash<TicTacToeMove> {
+    size_t operator()(const TicTacToeMove &m) const {
+        return std::hash<int>()((m.c.x + 1) * 16 + (m.c.y + 1));
+    }
+};
+
 class TicTacToeState : public GameState {
   private:
-    int state_;
+    long long state_;
 
   public:
-    explicit TicTacToeState(int state) {
+    explicit TicTacToeState(long long state) {
         state_ = state;
-        hash_ = std::hash<int>()(state_);
+        hash_ = std::hash<long long>()(state_);
     }
 
     string serialize() const override {
@@ -54,10 +66,10 @@ class TicTacToeState : public GameState {
     }
 
     static TicTacToeState deserialize(const string &serialized_state) {
-        return TicTacToeState(stoi(serialized_state));
+        return TicTacToeState(stoll(serialized_state));
     }
 
-    int get() const {
+    long long get() const {
         return state_;
     }
 
@@ -68,26 +80,48 @@ class TicTacToeState : public GameState {
 
 template <> struct std::hash<TicTacToeState> : public std::hash<GameState> { using std::hash<GameState>::operator(); };
 
-class TicTacToeGame : public Game<TicTacToeState, TicTacToeMove> {
+/* m,n,k-game: players take turns on a board of N rows and M columns, and the first one to get K in a row wins. */
+template <int N, int M, int K> class BasicTicTacToeGame : public Game<TicTacToeState, TicTacToeMove> {
+    static_assert(1 <= K and K <= N and K <= M, "TicTacToe lines have to fit in the board");
+    static_assert(N * M + 1 <= 39, "TicTacToe states are encoded as base 3 numbers of at most 63 bits");
+
   private:
-    /* Board is N x N. */
-    static constexpr int N = 3;
+    using BaseGame = Game<TicTacToeState, TicTacToeMove>;
 
     /* Cell state constants. */
-    static constexpr int CROSS = Game<TicTacToeState, TicTacToeMove>::PLAYER_MAX;
-    static constexpr int CIRCLE = Game<TicTacToeState, TicTacToeMove>::PLAYER_MIN;
-    static constexpr int NONE = Game<TicTacToeState, TicTacToeMove>::PLAYER_NONE;
+    static constexpr int CROSS = BaseGame::PLAYER_MAX;
+    static constexpr int CIRCLE = BaseGame::PLAYER_MIN;
+    static constexpr int NONE = BaseGame::PLAYER_NONE;
+
+    /* Every line of K cells, generated at compile time. */
+    static constexpr auto LINES = get_board_lines<N, M, K>();
+
+    /* Rectangular boards only have the even symmetries of the square. */
+    static constexpr int SYMMETRY_STEP = N == M ? 1 : 2;
 
     /* Returns if the coordinate is inside the board. */
     static bool is_inside(const TicTacToeCell &c) {
-        return 0 <= c.x and c.x < N and 0 <= c.y and c.y < N;
+        return 0 <= c.x and c.x < N and 0 <= c.y and c.y < M;
     }
 
-    int board[N][N]; // Board.
+    /* Returns the cell mapped by the given symmetry. */
+    static TicTacToeCell get_symmetric_cell(TicTacToeCell c, int symmetry) {
+        return get_symmetric_board_cell<N, M>(c, symmetry);
+    }
 
-    /* Checks if a row, column or diagonal has been filled. */
+    /* Returns the digit of a cell in the encoded state. */
+    static int get_digit(int cell) {
+        return cell == CROSS ? 0 : (cell == CIRCLE ? 1 : 2);
+    }
+
+    int board[N][M]; // Board.
+
+    /* Checks if a player has K in a row. */
     bool has_someone_won_() const;
 
+    /* Returns the given board and the rest of the current game state converted to State. */
+    TicTacToeState encode_state(const int (&board_)[N][M]) const;
+
   protected:
     /* Returns the current game state converted to State. */
     TicTacToeState get_state_() const override;
@@ -107,16 +141,33 @@ class TicTacToeGame : public Game<TicTacToeState, TicTacToeMove> {
     /* Returns the winner. */
     int get_winner_() const override;
 
+    /* Returns the smallest of the states that are symmetric to the current one, and the symmetry that maps the current state into it. */
+    pair<TicTacToeState, int> get_canonical_state_() const override;
+
+    /* Returns the move mapped by the given symmetry. */
+    TicTacToeMove get_symmetric_move_(const TicTacToeMove &, int) const override;
+
+    /* Returns the symmetry that undoes the given symmetry. */
+    int get_inverse_symmetry_(int) const override;
+
   public:
-    TicTacToeGame();
-    TicTacToeGame(const TicTacToeState &);
+    BasicTicTacToeGame();
+    BasicTicTacToeGame(const TicTacToeState &);
 
     /* Returns if the move (x, y) is a valid move. */
     bool is_valid_move(const TicTacToeMove &) const override;
 
     /* Returns a value between -1 and 1 indicating how probable it is for the first player to win (1.0) or the other player to win (-1.0). */
-    using Game<TicTacToeState, TicTacToeMove>::evaluate;
+    using BaseGame::evaluate;
 
     /* Returns the board for printing. */
     operator string() const override;
-};
\ No newline at end of file
+};
+
+/* Standard 3 x 3 board with 3 in a row. */
+using TicTacToeGame = BasicTicTacToeGame<3, 3, 3>;
+
+/* Board sizes compiled in src/TicTacToeGame.cpp. */
+extern template class BasicTicTacToeGame<3, 3, 3>;
+extern template class BasicTicTacToeGame<4, 4, 4>;
+extern template class BasicTicTacToeGame<5, 5, 4>;
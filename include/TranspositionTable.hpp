@@ -0,0 +1,397 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <optional>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/* Fixed size table of search results keyed by state hashes, which several threads can probe and store at the same time without locks. Entries are
+   grouped in buckets of one cache line. Every entry stores its key XORed with its data, so an entry torn by two threads writing it at once fails
+   the check and reads as a miss. On Linux, the table can be mapped to a file, which keeps its entries between runs and shares them between the
+   processes that map it. */
+class TranspositionTable {
+  public:
+    /* Search result as stored in the table. */
+    class Entry {
+      public:
+        uint32_t move = 0;      // std::hash of the best move.
+        int32_t score = 0;      // Score of the search.
+        int32_t turn = 0;       // In which turn the best line ends, relative to the turn of the state.
+        int16_t height = -1;    // Height of the search. -1 if the entry is only a move ordering hint.
+        int8_t bound = 0;       // If score is exact, a lower bound or an upper bound.
+        int8_t winner = 0;      // Winner of the best line, or a value meaning it is not solved. Between -4 and 3.
+        bool pruned = false;    // Whether the other moves were not all considered.
+        uint8_t generation = 0; // Search in which this entry was written.
+    };
+
+  private:
+    /* Entry packed in three words, the first one being the key XORed with the other two. */
+    class PackedEntry {
+      public:
+        atomic<uint64_t> check{0};
+        atomic<uint64_t> first{0};
+        atomic<uint64_t> second{0};
+    };
+
+    /* Entries that share a cache line. */
+    static constexpr int BUCKET_SIZE = 2;
+
+    class alignas(64) Bucket {
+      public:
+        PackedEntry entries[BUCKET_SIZE];
+    };
+
+    /* Replacement cost of every search that passed since an entry was written, in plies of height. */
+    static constexpr int AGE_WEIGHT = 8;
+
+    /* File header, which takes the cache line before the buckets. */
+    static constexpr char MAGIC[4] = {'M', 'M', 'T', 'T'};
+    static constexpr int32_t VERSION = 1;
+    static constexpr int32_t KEY_FORMAT = 1; // Version of get_key and of the entry packing.
+    static constexpr int TAG_SIZE = 32;
+
+    class alignas(64) Header {
+      public:
+        char magic[4];
+        int32_t version;
+        int32_t key_format;
+        int32_t entry_size;
+        uint64_t bucket_count;
+        char tag[TAG_SIZE]; // Game of the entries.
+        uint8_t generation; // Last search written to the file.
+    };
+
+    void *memory = nullptr;          // Allocation, holding the header before the buckets if the table is mapped to a file.
+    size_t memory_size = 0;          // Size of the allocation.
+    Bucket *buckets = nullptr;       // Table.
+    size_t bucket_count = 0;         // Number of buckets, a power of 2.
+    bool mapped = false;             // True if the buckets were allocated with mmap.
+    Header *header = nullptr;        // Header of the file the table is mapped to, if any.
+    int file = -1;                   // File the table is mapped to, locked shared for as long as it is mapped. -1 if none.
+    atomic<uint8_t> generation = 0;  // Current search.
+
+    /* Returns a well mixed key of a state hash, so that states with similar hashes are spread over the table. Never 0 in practice, which is the
+       key of empty entries. */
+    static uint64_t get_key(size_t hash) {
+        uint64_t key = static_cast<uint64_t>(hash) + 0x9E3779B97F4A7C15ull;
+        key = (key ^ (key >> 33)) * 0xFF51AFD7ED558CCDull;
+        key = (key ^ (key >> 33)) * 0xC4CEB9FE1A85EC53ull;
+        return key ^ (key >> 33);
+    }
+
+    static pair<uint64_t, uint64_t> pack(const Entry &entry) {
+        uint64_t first = static_cast<uint32_t>(entry.score) | static_cast<uint64_t>(entry.move) << 32;
+        uint64_t second = static_cast<uint32_t>(entry.turn) | static_cast<uint64_t>(static_cast<uint16_t>(entry.height)) << 32 |
+                          static_cast<uint64_t>(entry.bound & 3) << 48 | static_cast<uint64_t>((entry.winner + 4) & 7) << 50 |
+                          static_cast<uint64_t>(entry.pruned) << 53 | static_cast<uint64_t>(entry.generation) << 56;
+        return {first, second};
+    }
+
+    static Entry unpack(uint64_t first, uint64_t second) {
+        Entry entry;
+        entry.score = static_cast<int32_t>(static_cast<uint32_t>(first));
+        entry.move = first >> 32;
+        entry.turn = static_cast<int32_t>(static_cast<uint32_t>(second));
+        entry.height = static_cast<int16_t>(static_cast<uint16_t>(second >> 32));
+        entry.bound = (second >> 48) & 3;
+        entry.winner = static_cast<int8_t>((second >> 50) & 7) - 4;
+        entry.pruned = (second >> 53) & 1;
+        entry.generation = second >> 56;
+        return entry;
+    }
+
+    Bucket &get_bucket(uint64_t key) const {
+        return buckets[key & (bucket_count - 1)];
+    }
+
+    /* Returns the largest number of buckets that fits in the given size. */
+    static size_t get_bucket_count(size_t megabytes) {
+        size_t count = 1;
+
+        while (2 * count * sizeof(Bucket) <= max<size_t>(megabytes, 1) << 20) {
+            count *= 2;
+        }
+
+        return count;
+    }
+
+    void allocate(size_t megabytes, bool huge_pages) {
+        bucket_count = get_bucket_count(megabytes);
+        size_t bytes = bucket_count * sizeof(Bucket);
+
+#ifdef __linux__
+        // Anonymous mappings are page aligned. Explicit huge pages need to be reserved by the system, otherwise transparent ones are requested.
+        memory = huge_pages ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0) : MAP_FAILED;
+
+        if (memory == MAP_FAILED) {
+            memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            if (memory == MAP_FAILED) {
+                throw bad_alloc();
+            }
+
+#ifdef MADV_HUGEPAGE
+            if (huge_pages) {
+                madvise(memory, bytes, MADV_HUGEPAGE);
+            }
+#endif
+        }
+
+        mapped = true;
+#else
+        memory = ::operator new(bytes, align_val_t(alignof(Bucket)));
+        mapped = false;
+#endif
+
+        memory_size = bytes;
+        buckets = static_cast<Bucket *>(memory);
+
+        for (size_t i = 0; i < bucket_count; i++) {
+            new (&buckets[i]) Bucket();
+        }
+    }
+
+    void deallocate() {
+        if (memory == nullptr) {
+            return;
+        }
+
+#ifdef __linux__
+        if (mapped) {
+            munmap(memory, memory_size);
+        }
+
+        // Closing the file releases its lock.
+        if (file >= 0) {
+            close(file);
+            file = -1;
+        }
+#else
+        ::operator delete(memory, align_val_t(alignof(Bucket)));
+#endif
+
+        memory = nullptr;
+        memory_size = 0;
+        buckets = nullptr;
+        bucket_count = 0;
+        header = nullptr;
+    }
+
+    /* Returns true if a header describes a table of the given size and tag, written by this version. */
+    static bool is_valid_header(const Header &header_, size_t bucket_count_, const char (&tag)[TAG_SIZE]) {
+        return memcmp(header_.magic, MAGIC, sizeof(MAGIC)) == 0 and header_.version == VERSION and header_.key_format == KEY_FORMAT and
+               header_.entry_size == sizeof(PackedEntry) and header_.bucket_count == bucket_count_ and memcmp(header_.tag, tag, TAG_SIZE) == 0;
+    }
+
+#ifdef __linux__
+    /* Returns true if a file holds a table of the given size and tag, written by this version. */
+    static bool is_valid_file(int file_, size_t bucket_count_, const char (&tag)[TAG_SIZE]) {
+        struct stat status;
+        Header file_header;
+        return fstat(file_, &status) == 0 and static_cast<size_t>(status.st_size) == sizeof(Header) + bucket_count_ * sizeof(Bucket) and
+               pread(file_, &file_header, sizeof(file_header), 0) == sizeof(file_header) and is_valid_header(file_header, bucket_count_, tag);
+    }
+#endif
+
+  public:
+    /* Allocates a table of at most the given size. Huge pages make probes miss the TLB less often when the system provides them. */
+    explicit TranspositionTable(size_t megabytes, bool huge_pages = false) {
+        allocate(megabytes, huge_pages);
+    }
+
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+    ~TranspositionTable() {
+        deallocate();
+    }
+
+    /* Reallocates the table, discarding its entries. Not safe while other threads use it. */
+    void resize(size_t megabytes, bool huge_pages = false) {
+        deallocate();
+        allocate(megabytes, huge_pages);
+    }
+
+    /* Maps the table to a file of the given size, discarding its current entries. The entries of the file are kept if its header matches the
+       size, the tag (which identifies the game) and the format of the table, and the file is reset otherwise, as long as no other table has it
+       mapped. A read only table loads the file and shares its memory with the other processes until an entry is stored, but never writes to it.
+       Returns false, leaving the table in memory, if the file can't be mapped, or if it doesn't match and is read only or mapped by other tables.
+       Not safe while other threads use the table. */
+    bool open(const string &path, size_t megabytes, const string &tag, bool read_only = false) {
+#ifdef __linux__
+        int new_file = ::open(path.c_str(), read_only ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+
+        if (new_file < 0) {
+            return false;
+        }
+
+        // Every table mapping the file keeps a shared lock on it, and a reset needs the only lock, so files in use are never truncated. Opening
+        // waits while another process resets the file.
+        flock(new_file, LOCK_SH);
+        size_t count = get_bucket_count(megabytes);
+        size_t bytes = sizeof(Header) + count * sizeof(Bucket);
+        char tag_[TAG_SIZE] = {};
+        strncpy(tag_, tag.c_str(), TAG_SIZE - 1);
+
+        bool valid = is_valid_file(new_file, count, tag_);
+
+        if (!valid and read_only) {
+            close(new_file);
+            return false;
+        }
+
+        // Resetting the file with zeros, which are empty entries, before writing its header. Upgrading the lock fails while other tables hold
+        // theirs, and it is released meanwhile, so another process may have set the file up in between.
+        if (!valid) {
+            if (flock(new_file, LOCK_EX | LOCK_NB) != 0) {
+                close(new_file);
+                return false;
+            }
+
+            valid = is_valid_file(new_file, count, tag_);
+
+            if (!valid and (ftruncate(new_file, 0) != 0 or ftruncate(new_file, bytes) != 0)) {
+                close(new_file);
+                return false;
+            }
+        }
+
+        void *file_memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, read_only ? MAP_PRIVATE : MAP_SHARED, new_file, 0);
+
+        if (file_memory == MAP_FAILED) {
+            close(new_file);
+            return false;
+        }
+
+        deallocate();
+        memory = file_memory;
+        memory_size = bytes;
+        mapped = true;
+        header = static_cast<Header *>(memory);
+        buckets = reinterpret_cast<Bucket *>(header + 1);
+        bucket_count = count;
+        file = new_file;
+
+        if (!valid) {
+            memcpy(header->magic, MAGIC, sizeof(MAGIC));
+            header->version = VERSION;
+            header->key_format = KEY_FORMAT;
+            header->entry_size = sizeof(PackedEntry);
+            header->bucket_count = count;
+            memcpy(header->tag, tag_, TAG_SIZE);
+            header->generation = 0;
+        }
+
+        generation = header->generation;
+        flock(file, LOCK_SH);
+        return true;
+#else
+        (void)path, (void)megabytes, (void)tag, (void)read_only;
+        return false;
+#endif
+    }
+
+    /* Returns true if the table is mapped to a file. */
+    bool is_file_backed() const {
+        return header != nullptr;
+    }
+
+    /* Returns the number of entries that fit in the table. */
+    size_t get_capacity() const {
+        return bucket_count * BUCKET_SIZE;
+    }
+
+    /* Discards every entry. */
+    void clear() {
+        for (size_t i = 0; i < bucket_count; i++) {
+            for (PackedEntry &packed : buckets[i].entries) {
+                packed.check.store(0, memory_order_relaxed);
+                packed.first.store(0, memory_order_relaxed);
+                packed.second.store(0, memory_order_relaxed);
+            }
+        }
+    }
+
+    /* Starts a new search, so that the entries of previous searches are replaced first. Returns its generation, which is also kept in the file
+       the table is mapped to so that the next runs keep aging the entries. */
+    uint8_t new_generation() {
+        uint8_t ans = ++generation;
+
+        if (header != nullptr) {
+            header->generation = ans;
+        }
+
+        return ans;
+    }
+
+    /* Starts loading the bucket of a state hash into the cache, ahead of probing or storing it. */
+    void prefetch(size_t hash) const {
+        __builtin_prefetch(&get_bucket(get_key(hash)));
+    }
+
+    /* Returns the entry of a state hash, if any. */
+    optional<Entry> probe(size_t hash) const {
+        uint64_t key = get_key(hash);
+
+        for (const PackedEntry &packed : get_bucket(key).entries) {
+            uint64_t first = packed.first.load(memory_order_relaxed), second = packed.second.load(memory_order_relaxed);
+
+            if ((packed.check.load(memory_order_relaxed) ^ first ^ second) == key) {
+                return unpack(first, second);
+            }
+        }
+
+        return nullopt;
+    }
+
+    /* Stores the entry of a state hash. An entry of the same state is kept if it is deeper and from the same generation. Otherwise the entry
+       that is the oldest and shallowest of the bucket is replaced. */
+    void store(size_t hash, const Entry &entry) {
+        uint64_t key = get_key(hash);
+        PackedEntry *replaced = nullptr;
+        int replaced_value = 0;
+
+        for (PackedEntry &packed : get_bucket(key).entries) {
+            uint64_t first = packed.first.load(memory_order_relaxed), second = packed.second.load(memory_order_relaxed);
+            uint64_t check = packed.check.load(memory_order_relaxed);
+            Entry old = unpack(first, second);
+
+            if ((check ^ first ^ second) == key) {
+                if (old.generation == entry.generation and old.height > entry.height) {
+                    return;
+                }
+
+                replaced = &packed;
+                break;
+            }
+
+            int value = check == 0 and first == 0 and second == 0 ? numeric_limits<int>::min()
+                                                                  : old.height - AGE_WEIGHT * static_cast<uint8_t>(entry.generation - old.generation);
+
+            if (replaced == nullptr or value < replaced_value) {
+                replaced = &packed;
+                replaced_value = value;
+            }
+        }
+
+        auto [first, second] = pack(entry);
+        replaced->first.store(first, memory_order_relaxed);
+        replaced->second.store(second, memory_order_relaxed);
+        replaced->check.store(key ^ first ^ second, memory_order_relaxed);
+    }
+};
@@ -1,3 +1,4 @@
+#include <cassert>
 #include <cctype>
 #include <cstring>
 #include <optional>
@@ -13,6 +14,9 @@ using namespace std;
 constexpr int BaghChalGame::DIR[8][2];
 constexpr int BaghChalGame::INV_DIR[3][3];
 
+Parameter BaghChalGame::weights[FEATURES] = {{"BaghChal.stuck_wolves", 0.04}, {"BaghChal.dead_sheeps", -0.16}};
+Network<BaghChalGame::NETWORK_INPUTS> BaghChalGame::network;
+
 /* ---------- PRIVATE ---------- */
 
 /* Returns true if SHEEP player is still placing sheeps on the board. */
@@ -133,19 +137,17 @@ vector<BaghChalMove> BaghChalGame::get_moves_for_(int player) const {
     return moves;
 }
 
-/* ---------- PROTECTED ---------- */
-
-/* Returns the current game state converted to State. */
-BaghChalState BaghChalGame::get_state_() const {
+/* Returns the given board and the rest of the current game state converted to State. */
+BaghChalState BaghChalGame::encode_state(const int (&board_)[N][N]) const {
     long long state = 0;
     long long pow = 1;
 
     // Board.
     for (int x = 0; x < N; x++) {
         for (int y = 0; y < N; y++) {
-            if (board[x][y] == SHEEP) {
+            if (board_[x][y] == SHEEP) {
                 state += 0 * pow;
-            } else if (board[x][y] == WOLF) {
+            } else if (board_[x][y] == WOLF) {
                 state += 1 * pow;
             } else {
                 state += 2 * pow;
@@ -176,6 +178,37 @@ BaghChalState BaghChalGame::get_state_() const {
     return BaghChalState(state);
 }
 
+/* Returns the inputs of the evaluation network for the current board with the given player to move. */
+bitset<BaghChalGame::NETWORK_INPUTS> BaghChalGame::encode_network_inputs(int player) const {
+    bitset<NETWORK_INPUTS> inputs;
+
+    for (int p = 0; p < N * N; p++) {
+        BaghChalCell c = convert_cell(p);
+
+        if (board[c.x][c.y] != NONE) {
+            inputs.set((board[c.x][c.y] == SHEEP ? 0 : N * N) + p);
+        }
+    }
+
+    inputs.set(2 * N * N + sheeps);
+    inputs.set(NETWORK_INPUTS - 1, player == SHEEP);
+    return inputs;
+}
+
+/* Updates the accumulators of the evaluation network after the board changes, with the given player to move. */
+void BaghChalGame::update_accumulators(int player) {
+    if (network.is_loaded()) {
+        accumulators.update(network, encode_network_inputs(player));
+    }
+}
+
+/* ---------- PROTECTED ---------- */
+
+/* Returns the current game state converted to State. */
+BaghChalState BaghChalGame::get_state_() const {
+    return encode_state(board);
+}
+
 /* Loads the game given a State. */
 void BaghChalGame::load_game_(const BaghChalState &state_) {
     long long state = state_.get();
@@ -213,6 +246,8 @@ void BaghChalGame::load_game_(const BaghChalState &state_) {
     } else {
         set_player_(NONE);
     }
+
+    update_accumulators(get_player());
 }
 
 /* Performs a move. Assumes that is_valid_move(m) is true. TODO: Remove assumption that is_valid_move(m) is true. */
@@ -227,6 +262,8 @@ void BaghChalGame::make_move_(const BaghChalMove &m) {
             board[(m.ci.x + m.cf.x) / 2][(m.ci.y + m.cf.y) / 2] = NONE;
         }
     }
+
+    update_accumulators(get_enemy());
 }
 
 /* Returns a move inputed by the player. */
@@ -259,10 +296,74 @@ vector<BaghChalMove> BaghChalGame::get_moves_() const {
 
 /* Returns a value between -1 and 1 indicating how probable it is for the first player to win (1.0) or the other player to win (-1.0). */
 double BaghChalGame::evaluate_() const {
-    // Pretending that we are SHEEP.
-    int stuck_wolves = stuck_wolves_count();
-    int dead_sheep = 20 - sheep_count();
-    return stuck_wolves * 0.04 - dead_sheep * 0.16;
+    if (network.is_loaded()) {
+        if (accumulators.empty()) {
+            return network.evaluate(get_network_inputs());
+        }
+
+#ifdef DEBUG
+        assert(accumulators.top().inputs == get_network_inputs());
+#endif
+
+        return network.evaluate(accumulators.top());
+    }
+
+    array<double, FEATURES> features = get_features();
+    double score = 0.0;
+
+    for (int i = 0; i < FEATURES; i++) {
+        score += features[i] * weights[i].get();
+    }
+
+    return score;
+}
+
+/* Returns the smallest of the states that are symmetric to the current one, and the symmetry that maps the current state into it. */
+pair<BaghChalState, int> BaghChalGame::get_canonical_state_() const {
+    int best_symmetry = get_smallest_board_symmetry<N, N, BaghChalCell>(1, [&](int x, int y) { return get_digit(board[x][y]); });
+
+    if (best_symmetry == 0) {
+        return {get_state(), 0};
+    }
+
+    int symmetric_board[N][N];
+
+    for (int x = 0; x < N; x++) {
+        for (int y = 0; y < N; y++) {
+            BaghChalCell c = get_symmetric_cell(BaghChalCell(x, y), best_symmetry);
+            symmetric_board[c.x][c.y] = board[x][y];
+        }
+    }
+
+    return {encode_state(symmetric_board), best_symmetry};
+}
+
+/* Returns the move mapped by the given symmetry. */
+BaghChalMove BaghChalGame::get_symmetric_move_(const BaghChalMove &m, int symmetry) const {
+    return BaghChalMove(get_symmetric_cell(m.ci, symmetry), get_symmetric_cell(m.cf, symmetry));
+}
+
+/* Returns the symmetry that undoes the given symmetry. */
+int BaghChalGame::get_inverse_symmetry_(int symmetry) const {
+    return get_inverse_board_symmetry(symmetry);
+}
+
+/* Returns true if the move is a capture. Sheep placements have no final cell. */
+bool BaghChalGame::is_forcing_move_(const BaghChalMove &m) const {
+    return !(m.cf == BaghChalCell(-1, -1)) and chebyshev_distance(m.ci, m.cf) == 2;
+}
+
+/* Returns the captures. */
+vector<BaghChalMove> BaghChalGame::get_noisy_moves_() const {
+    vector<BaghChalMove> moves;
+
+    for (const BaghChalMove &m : get_moves()) {
+        if (is_forcing_move_(m)) {
+            moves.push_back(m);
+        }
+    }
+
+    return moves;
 }
 
 /* ---------- PUBLIC ---------- */
@@ -280,6 +381,16 @@ BaghChalGame::BaghChalGame(const BaghChalState &state) {
     Game<BaghChalState, BaghChalMove>::initialize_game_();
 }
 
+/* Returns the evaluation features (stuck wolves and dead sheeps), pretending that we are SHEEP. */
+array<double, BaghChalGame::FEATURES> BaghChalGame::get_features() const {
+    return {static_cast<double>(stuck_wolves_count()), static_cast<double>(20 - sheep_count())};
+}
+
+/* Returns the inputs of the evaluation network. */
+bitset<BaghChalGame::NETWORK_INPUTS> BaghChalGame::get_network_inputs() const {
+    return encode_network_inputs(get_player());
+}
+
 /* Returns true if the movement is valid. */
 bool BaghChalGame::is_valid_move(const BaghChalMove &m) const {
     if (m.cf == BaghChalCell(-1, -1)) { // Sheep move during first phase.
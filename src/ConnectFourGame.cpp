@@ -1,159 +1,189 @@
 #include <cstdio>
 #include <cstring>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 #include <Common.hpp>
 #include <ConnectFourGame.hpp>
 
-// C++ is weird.
-constexpr int ConnectFourGame::DIR[4][2];
+template <int N, int M>
+Parameter BasicConnectFourGame<N, M>::weights[FEATURES] = {
+    {get_name() + ".windows_1", 2.0 / MAX_SCORE}, {get_name() + ".windows_2", 3.0 / MAX_SCORE}, {get_name() + ".windows_3", 4.0 / MAX_SCORE}};
 
-/* ---------- PRIVATE ---------- */
+/* ---------- STATE ---------- */
 
-/* Returns the score of the board for the given player. */
-int ConnectFourGame::get_score_(int player) const {
-    int enemy = player == YELLOW ? RED : YELLOW;
-    int score = 0;
-    int i;
+/* Returns the state as text: the yellow and the red cells as decimal bitmasks, separated by the player to move (y, r or n). */
+template <int N, int M> string BasicConnectFourState<N, M>::serialize() const {
+    using GameType = BasicConnectFourGame<N, M>;
+    int board[N][M];
+    int player = GameType::decode_state(*this, board);
+    Bitboard<N * M> yellow = 0, red = 0, pow = 1;
 
     for (int x = 0; x < N; x++) {
         for (int y = 0; y < M; y++) {
-            for (int d = 0; d < 4; d++) {
-                // Considering all possible win conditions (4 cells connected).
-                if (!is_inside(x + 3 * DIR[d][0], y + 3 * DIR[d][1])) {
-                    continue;
-                }
-
-                int player_count = 0;
+            if (board[x][y] == GameType::YELLOW) {
+                yellow |= pow;
+            } else if (board[x][y] == GameType::RED) {
+                red |= pow;
+            }
 
-                for (i = 0; i < 4; i++) {
-                    int xf = x + i * DIR[d][0];
-                    int yf = y + i * DIR[d][1];
+            pow *= 2;
+        }
+    }
 
-                    if (board[xf][yf] == enemy) {
-                        break;
-                    }
+    string separator = player == GameType::YELLOW ? "y" : player == GameType::RED ? "r" : "n";
+    return bits_to_string(yellow) + separator + bits_to_string(red);
+}
 
-                    player_count += board[xf][yf] == player;
-                }
+/* Reads a state written by serialize(). Throws invalid_argument if it isn't a valid board. */
+template <int N, int M> BasicConnectFourState<N, M> BasicConnectFourState<N, M>::deserialize(const string &serialized_state) {
+    using GameType = BasicConnectFourGame<N, M>;
+    int pos = serialized_state.find_first_of("yrn");
 
-                // If no enemies were found in this 4 sequence.
-                if (i == 4) {
-                    score += player_count + 1;
-                }
-            }
-        }
+    if (pos == string::npos) {
+        throw invalid_argument("missing player in ConnectFour state");
     }
 
-    return score;
-}
+    // Current player.
+    int player = serialized_state[pos] == 'y' ? GameType::YELLOW : serialized_state[pos] == 'r' ? GameType::RED : GameType::NONE;
+    Bitboard<N * M> yellow = string_to_bits<Bitboard<N * M>>(serialized_state.substr(0, pos));
+    Bitboard<N * M> red = string_to_bits<Bitboard<N * M>>(serialized_state.substr(pos + 1));
 
-/* Checks if there are 4 pieces connected. */
-bool ConnectFourGame::has_someone_won_() const {
-    int i;
+    // Board.
+    int board[N][M];
 
     for (int x = 0; x < N; x++) {
         for (int y = 0; y < M; y++) {
-            if (board[x][y] != NONE) {
-                for (int d = 0; d < 4; d++) {
-                    if (!is_inside(x + 3 * DIR[d][0], y + 3 * DIR[d][1])) {
-                        continue;
-                    }
+            if ((yellow & 1) and (red & 1)) {
+                throw invalid_argument("ConnectFour cell with two pieces");
+            }
 
-                    for (i = 1; i < 4; i++) {
-                        int xf = x + i * DIR[d][0];
-                        int yf = y + i * DIR[d][1];
+            board[x][y] = yellow & 1 ? GameType::YELLOW : red & 1 ? GameType::RED : GameType::NONE;
 
-                        if (!is_inside(xf, yf) or board[xf][yf] != board[x][y]) {
-                            break;
-                        }
-                    }
-
-                    if (i == 4) {
-                        return true;
-                    }
-                }
+            if (x > 0 and board[x - 1][y] != GameType::NONE and board[x][y] == GameType::NONE) {
+                throw invalid_argument("ConnectFour piece above an empty cell");
             }
+
+            yellow /= 2;
+            red /= 2;
         }
     }
 
-    return false;
+    return GameType::encode_state(board, player);
 }
 
-/* ---------- PROTECTED ---------- */
+/* ---------- PRIVATE ---------- */
 
-/* Returns the current game state converted to State. */
-ConnectFourState ConnectFourGame::get_state_() const {
-    long long yellow = 0, red = 0, pow = 1;
+/* Counts the possible win conditions (4 cells connected) without enemy pieces, by the number of pieces of the given player in them. */
+template <int N, int M> array<int, 5> BasicConnectFourGame<N, M>::count_windows_(int player) const {
+    int enemy = player == YELLOW ? RED : YELLOW;
+    array<int, 5> counts = {};
+    int i;
 
-    // Board.
-    for (int x = 0; x < N; x++) {
-        for (int y = 0; y < M; y++) {
-            if (board[x][y] == YELLOW) {
-                yellow |= pow;
-            } else if (board[x][y] == RED) {
-                red |= pow;
+    for (const auto &window : WINDOWS) {
+        int player_count = 0;
+
+        for (i = 0; i < 4; i++) {
+            int cell = board[window[i][0]][window[i][1]];
+
+            if (cell == enemy) {
+                break;
             }
 
-            pow *= 2;
+            player_count += cell == player;
         }
-    }
 
-    // Current player.
-    if (get_player() == YELLOW) {
-        return ConnectFourState(to_string(yellow) + "y" + to_string(red));
+        // If no enemies were found in this 4 sequence.
+        if (i == 4) {
+            counts[player_count]++;
+        }
     }
 
-    if (get_player() == RED) {
-        return ConnectFourState(to_string(yellow) + "r" + to_string(red));
+    return counts;
+}
+
+/* Checks if there are 4 pieces connected. */
+template <int N, int M> bool BasicConnectFourGame<N, M>::has_someone_won_() const {
+    int i;
+
+    for (const auto &window : WINDOWS) {
+        int first = board[window[0][0]][window[0][1]];
+
+        if (first != NONE) {
+            for (i = 1; i < 4; i++) {
+                if (board[window[i][0]][window[i][1]] != first) {
+                    break;
+                }
+            }
+
+            if (i == 4) {
+                return true;
+            }
+        }
     }
 
-    return ConnectFourState(to_string(yellow) + "n" + to_string(red));
+    return false;
 }
 
-/* Loads the game given a State. */
-void ConnectFourGame::load_game_(const ConnectFourState &state_) {
-    const string &state = state_.get();
-    int pos = state.find("y");
+/* Returns the given board and player converted to State. */
+template <int N, int M> BasicConnectFourState<N, M> BasicConnectFourGame<N, M>::encode_state(const int (&board_)[N][M], int player) {
+    BitsType state = 0;
 
-    // Current player.
-    if (pos == string::npos) {
-        pos = state.find("r");
+    // Board.
+    for (int y = 0; y < M; y++) {
+        int height = 0;
 
-        if (pos == string::npos) {
-            pos = state.find("n");
-            set_player_(NONE);
-        } else {
-            set_player_(RED);
+        for (int x = N - 1; x >= 0 and board_[x][y] != NONE; x--, height++) {
+            state |= static_cast<BitsType>(board_[x][y] == YELLOW) << (y * COLUMN_BITS + height);
         }
-    } else {
-        set_player_(YELLOW);
+
+        state |= static_cast<BitsType>(1) << (y * COLUMN_BITS + height);
     }
 
-    long long yellow = stoll(state.substr(0, pos));
-    long long red = stoll(state.substr(pos + 1));
+    // Current player.
+    BitsType player_code = player == YELLOW ? 0 : player == RED ? 1 : 2;
+    return ConnectFourState(state | player_code << PLAYER_SHIFT);
+}
+
+/* Loads the board of a State and returns its player to move. */
+template <int N, int M> int BasicConnectFourGame<N, M>::decode_state(const ConnectFourState &state_, int (&board_)[N][M]) {
+    BitsType state = state_.get();
 
     // Board.
-    for (int x = 0; x < N; x++) {
-        for (int y = 0; y < M; y++) {
-            if (yellow & 1) {
-                board[x][y] = YELLOW;
-            } else if (red & 1) {
-                board[x][y] = RED;
-            } else {
-                board[x][y] = NONE;
-            }
+    for (int y = 0; y < M; y++) {
+        uint64_t column = static_cast<uint64_t>(state >> (y * COLUMN_BITS)) & ((1ull << COLUMN_BITS) - 1);
+        int height = N;
 
-            yellow /= 2;
-            red /= 2;
+        while (height > 0 and !(column >> height & 1)) {
+            height--;
+        }
+
+        for (int x = N - 1, i = 0; x >= 0; x--, i++) {
+            board_[x][y] = i >= height ? NONE : column >> i & 1 ? YELLOW : RED;
         }
     }
+
+    // Current player.
+    uint64_t player_code = static_cast<uint64_t>(state >> PLAYER_SHIFT);
+    return player_code == 0 ? YELLOW : player_code == 1 ? RED : NONE;
+}
+
+/* ---------- PROTECTED ---------- */
+
+/* Returns the current game state converted to State. */
+template <int N, int M> BasicConnectFourState<N, M> BasicConnectFourGame<N, M>::get_state_() const {
+    return encode_state(board, get_player());
+}
+
+/* Loads the game given a State. */
+template <int N, int M> void BasicConnectFourGame<N, M>::load_game_(const ConnectFourState &state_) {
+    set_player_(decode_state(state_, board));
 }
 
 /* Performs a move. Assumes that is_valid_move(m) is true. TODO: Remove assumption that is_valid_move(m) is true. */
-void ConnectFourGame::make_move_(const ConnectFourMove &m) {
+template <int N, int M> void BasicConnectFourGame<N, M>::make_move_(const ConnectFourMove &m) {
     for (int x = N - 1; x >= 0; x--) {
         if (board[x][m.y] == NONE) {
             board[x][m.y] = get_player();
@@ -163,7 +193,7 @@ void ConnectFourGame::make_move_(const ConnectFourMove &m) {
 }
 
 /* Returns a move inputed by the player. */
-optional<ConnectFourMove> ConnectFourGame::get_player_move_(const string &command) const {
+template <int N, int M> optional<ConnectFourMove> BasicConnectFourGame<N, M>::get_player_move_(const string &command) const {
     int p;
 
     if (sscanf(command.c_str(), "%d", &p) != 1) {
@@ -178,7 +208,7 @@ optional<ConnectFourMove> ConnectFourGame::get_player_move_(const string &comman
 }
 
 /* Returns all the current possible moves. */
-vector<ConnectFourMove> ConnectFourGame::get_moves_() const {
+template <int N, int M> vector<ConnectFourMove> BasicConnectFourGame<N, M>::get_moves_() const {
     vector<ConnectFourMove> moves;
 
     if (has_someone_won_()) {
@@ -195,40 +225,93 @@ vector<ConnectFourMove> ConnectFourGame::get_moves_() const {
 }
 
 /* Returns the winner. */
-int ConnectFourGame::get_winner_() const {
+template <int N, int M> int BasicConnectFourGame<N, M>::get_winner_() const {
     if (has_someone_won_()) {
-        return Game<ConnectFourState, ConnectFourMove>::get_winner_();
+        return BaseGame::get_winner_();
     }
 
     return NONE;
 }
 
 /* Returns a value between -1 and 1 indicating how probable it is for the first player to win (1.0) or the other player to win (-1.0). */
-double ConnectFourGame::evaluate_() const {
-    int score = get_score_(YELLOW) - get_score_(RED);
-    return score / static_cast<double>(MAX_SCORE);
+template <int N, int M> double BasicConnectFourGame<N, M>::evaluate_() const {
+    array<double, FEATURES> features = get_features();
+    double score = 0.0;
+
+    for (int i = 0; i < FEATURES; i++) {
+        score += features[i] * weights[i].get();
+    }
+
+    return score;
+}
+
+/* Returns the smallest of the states that are symmetric to the current one, and the symmetry that maps the current state into it. */
+template <int N, int M> pair<BasicConnectFourState<N, M>, int> BasicConnectFourGame<N, M>::get_canonical_state_() const {
+    // The most significant cell in which the board and its mirror differ decides which state is smaller, comparing yellow cells first.
+    for (int color : {YELLOW, RED}) {
+        for (int x = N - 1; x >= 0; x--) {
+            for (int y = M - 1; y >= 0; y--) {
+                bool cell = board[x][y] == color, mirrored_cell = board[x][M - 1 - y] == color;
+
+                if (cell != mirrored_cell) {
+                    if (cell < mirrored_cell) {
+                        return {get_state(), 0};
+                    }
+
+                    int mirrored_board[N][M];
+
+                    for (int x_ = 0; x_ < N; x_++) {
+                        for (int y_ = 0; y_ < M; y_++) {
+                            mirrored_board[x_][M - 1 - y_] = board[x_][y_];
+                        }
+                    }
+
+                    return {encode_state(mirrored_board, get_player()), 1};
+                }
+            }
+        }
+    }
+
+    return {get_state(), 0};
+}
+
+/* Returns the move mapped by the given symmetry. */
+template <int N, int M> ConnectFourMove BasicConnectFourGame<N, M>::get_symmetric_move_(const ConnectFourMove &m, int symmetry) const {
+    return symmetry == 1 ? ConnectFourMove(M - 1 - m.y) : m;
 }
 
 /* ---------- PUBLIC ---------- */
 
-ConnectFourGame::ConnectFourGame() {
+template <int N, int M> BasicConnectFourGame<N, M>::BasicConnectFourGame() {
     memset(board, NONE, sizeof(board));
     set_player_(YELLOW);
-    Game<ConnectFourState, ConnectFourMove>::initialize_game_();
+    BaseGame::initialize_game_();
 }
 
-ConnectFourGame::ConnectFourGame(const ConnectFourState &state) {
+template <int N, int M> BasicConnectFourGame<N, M>::BasicConnectFourGame(const ConnectFourState &state) {
     load_game_(state);
-    Game<ConnectFourState, ConnectFourMove>::initialize_game_();
+    BaseGame::initialize_game_();
+}
+
+/* Returns the evaluation features: for 1, 2 and 3 pieces, the win conditions of YELLOW with that many pieces and no enemy ones, minus those of RED. */
+template <int N, int M> array<double, BasicConnectFourGame<N, M>::FEATURES> BasicConnectFourGame<N, M>::get_features() const {
+    array<int, 5> yellow = count_windows_(YELLOW), red = count_windows_(RED);
+    array<double, FEATURES> features;
+
+    for (int i = 0; i < FEATURES; i++) {
+        features[i] = yellow[i + 1] - red[i + 1];
+    }
+
+    return features;
 }
 
 /* Returns if the move (x, y) is a valid move. */
-bool ConnectFourGame::is_valid_move(const ConnectFourMove &m) const {
+template <int N, int M> bool BasicConnectFourGame<N, M>::is_valid_move(const ConnectFourMove &m) const {
     return 0 <= m.y and m.y < M and board[0][m.y] == NONE;
 }
 
 /* Returns the board for printing. */
-ConnectFourGame::operator string() const {
+template <int N, int M> BasicConnectFourGame<N, M>::operator string() const {
     string str;
 
     for (int y = 0; y < M; y++) {
@@ -274,4 +357,11 @@ ConnectFourGame::operator string() const {
     }
 
     return str;
-}
\ No newline at end of file
+}
+
+/* ---------- BOARD SIZES ---------- */
+
+template class BasicConnectFourState<6, 7>;
+template class BasicConnectFourGame<6, 7>;
+template class BasicConnectFourState<7, 8>;
+template class BasicConnectFourGame<7, 8>;
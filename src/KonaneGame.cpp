@@ -1,5 +1,6 @@
 #include <cassert>
 #include <cstdio>
+#include <cstdlib>
 #include <optional>
 #include <string>
 #include <vector>
@@ -7,19 +8,18 @@
 #include <Common.hpp>
 #include <KonaneGame.hpp>
 
-// C++ is weird.
-constexpr int KonaneGame::DIR[2][4];
+template <int N, int M> Network<BasicKonaneGame<N, M>::NETWORK_INPUTS> BasicKonaneGame<N, M>::network;
 
 /* ---------- PRIVATE ---------- */
 
 /* Returns the number of pawns remaining on the board. */
-int KonaneGame::count_pawns() const {
-    return __builtin_popcountll(board);
+template <int N, int M> int BasicKonaneGame<N, M>::count_pawns() const {
+    return count_bits(board);
 }
 
 /* Returns what is in cell (x, y). */
-int KonaneGame::test(const KonaneCell &c) const {
-    if ((board >> (long long)convert_cell(c)) & 1ll) {
+template <int N, int M> int BasicKonaneGame<N, M>::test(const KonaneCell &c) const {
+    if ((board >> convert_cell(c)) & 1) {
         return (c.x + c.y) % 2 ? WHITE : BLACK;
     }
 
@@ -27,41 +27,41 @@ int KonaneGame::test(const KonaneCell &c) const {
 }
 
 /* Sets cell (x, y). */
-void KonaneGame::set(const KonaneCell &c) {
-    board |= (1ll << (long long)convert_cell(c));
+template <int N, int M> void BasicKonaneGame<N, M>::set(const KonaneCell &c) {
+    board |= BoardType(1) << convert_cell(c);
 }
 
 /* Resets cell (x, y). */
-void KonaneGame::reset(const KonaneCell &c) {
-    board &= ~(1ll << (long long)convert_cell(c));
+template <int N, int M> void BasicKonaneGame<N, M>::reset(const KonaneCell &c) {
+    board &= ~(BoardType(1) << convert_cell(c));
 }
 
 /* Returns true if the next move is the first move of the match. */
-bool KonaneGame::is_first_turn() const {
-    return count_pawns() == N * N;
+template <int N, int M> bool BasicKonaneGame<N, M>::is_first_turn() const {
+    return count_pawns() == N * M;
 }
 
 /* Returns true if the next move is the second move of the match. */
-bool KonaneGame::is_second_turn() const {
-    return count_pawns() == N * N - 1;
+template <int N, int M> bool BasicKonaneGame<N, M>::is_second_turn() const {
+    return count_pawns() == N * M - 1;
 }
 
 /* Returns if the move (x, y) at the start of the game is a valid move. */
-bool KonaneGame::is_valid_starting_move(const KonaneCell &c) const {
+template <int N, int M> bool BasicKonaneGame<N, M>::is_valid_starting_move(const KonaneCell &c) const {
     if (!is_inside(c)) {
         return false;
     }
 
-    if (is_first_turn()) {                                    // First move.
-        if (c == KonaneCell(3, 2) or c == KonaneCell(2, 3)) { // Center.
+    if (is_first_turn()) {                                  // First move.
+        if (c == WHITE_CENTER[0] or c == WHITE_CENTER[1]) { // Center.
             return true;
         }
 
-        if (c == KonaneCell(5, 0)) { // Bottom corner.
+        if (c == BOTTOM_CORNER) { // Bottom corner.
             return true;
         }
 
-        if (c == KonaneCell(0, 5)) { // Top corner.
+        if (c == TOP_CORNER) { // Top corner.
             return true;
         }
 
@@ -69,17 +69,17 @@ bool KonaneGame::is_valid_starting_move(const KonaneCell &c) const {
         return false;
     }
 
-    if (is_second_turn()) {                                                     // Second move.
-        if (test(KonaneCell(3, 2)) == NONE or test(KonaneCell(2, 3)) == NONE) { // Center.
-            return c == KonaneCell(2, 2) or c == KonaneCell(3, 3);
+    if (is_second_turn()) {                                                   // Second move.
+        if (test(WHITE_CENTER[0]) == NONE or test(WHITE_CENTER[1]) == NONE) { // Center.
+            return c == BLACK_CENTER[0] or c == BLACK_CENTER[1];
         }
 
-        if (test(KonaneCell(5, 0)) == NONE) { // Bottom corner.
-            return c == KonaneCell(4, 0) or c == KonaneCell(5, 1);
+        if (test(BOTTOM_CORNER) == NONE) { // Bottom corner.
+            return c == KonaneCell(N - 2, 0) or c == KonaneCell(N - 1, 1);
         }
 
-        if (test(KonaneCell(0, 5)) == NONE) { // Top corner.
-            return c == KonaneCell(0, 4) or c == KonaneCell(1, 5);
+        if (test(TOP_CORNER) == NONE) { // Top corner.
+            return c == KonaneCell(0, M - 2) or c == KonaneCell(1, M - 1);
         }
 
         // The current state is corrupted.
@@ -92,16 +92,16 @@ bool KonaneGame::is_valid_starting_move(const KonaneCell &c) const {
 }
 
 /* Makes the move (x, y) for the first two moves in the game. Assumes that isValidMove(x, y) is true. */
-void KonaneGame::make_starting_move(const KonaneMove &m) {
+template <int N, int M> void BasicKonaneGame<N, M>::make_starting_move(const KonaneMove &m) {
     reset(m.ci);
 }
 
 /* Returns all the possible start moves. */
-vector<KonaneMove> KonaneGame::get_starting_moves() const {
+template <int N, int M> vector<KonaneMove> BasicKonaneGame<N, M>::get_starting_moves() const {
     vector<KonaneMove> moves;
 
     for (int x = 0; x < N; x++) {
-        for (int y = 0; y < N; y++) {
+        for (int y = 0; y < M; y++) {
             if (is_valid_starting_move(KonaneCell(x, y))) {
                 moves.push_back(KonaneMove(x, y, -1, -1));
             }
@@ -111,40 +111,70 @@ vector<KonaneMove> KonaneGame::get_starting_moves() const {
     return moves;
 }
 
-/* ---------- PROTECTED ---------- */
-
-/* Returns the current game state converted to State. */
-KonaneState KonaneGame::get_state_() const {
+/* Returns the given board and the rest of the current game state converted to State. */
+template <int N, int M> BasicKonaneState<N, M> BasicKonaneGame<N, M>::encode_state(BoardType board_) const {
     if (get_player() == WHITE) {
-        return KonaneState(board | (1ll << N * N));
+        return KonaneState(BitsType(board_) | BitsType(1) << (N * M));
     }
 
     if (get_player() == BLACK) {
-        return KonaneState(board | (1ll << (N * N + 1)));
+        return KonaneState(BitsType(board_) | BitsType(1) << (N * M + 1));
+    }
+
+    return KonaneState(board_);
+}
+
+/* Returns the inputs of the evaluation network for the current board with the given player to move. */
+template <int N, int M> bitset<BasicKonaneGame<N, M>::NETWORK_INPUTS> BasicKonaneGame<N, M>::encode_network_inputs(int player) const {
+    bitset<NETWORK_INPUTS> inputs;
+
+    if constexpr (N * M <= 64) {
+        inputs = bitset<NETWORK_INPUTS>(board);
+    } else {
+        for (int p = 0; p < N * M; p++) {
+            inputs.set(p, (board >> p) & 1);
+        }
+    }
+
+    inputs.set(N * M, player == WHITE);
+    return inputs;
+}
+
+/* Updates the accumulators of the evaluation network after the board changes, with the given player to move. */
+template <int N, int M> void BasicKonaneGame<N, M>::update_accumulators(int player) {
+    if (network.is_loaded()) {
+        accumulators.update(network, encode_network_inputs(player));
     }
+}
+
+/* ---------- PROTECTED ---------- */
 
-    return KonaneState(board);
+/* Returns the current game state converted to State. */
+template <int N, int M> BasicKonaneState<N, M> BasicKonaneGame<N, M>::get_state_() const {
+    return encode_state(board);
 }
 
 /* Loads the game given a State. */
-void KonaneGame::load_game_(const KonaneState &state_) {
-    long long state = state_.get();
+template <int N, int M> void BasicKonaneGame<N, M>::load_game_(const KonaneState &state_) {
+    BitsType state = state_.get();
 
     // Current player.
-    if ((state >> (N * N)) & 1ll) {
+    if ((state >> (N * M)) & 1) {
         set_player_(WHITE);
-    } else if ((state >> (N * N + 1)) & 1ll) {
+    } else if ((state >> (N * M + 1)) & 1) {
         set_player_(BLACK);
     } else {
         set_player_(NONE);
     }
 
     // Board.
-    board = state & ((1ll << (N * N)) - 1);
+    board = static_cast<BoardType>(state & FULL_BOARD);
+
+    update_accumulators(get_player());
 }
 
 /* Performs a move. Assumes that is_valid_move(m) is true. TODO: Remove assumption that is_valid_move(m) is true. */
-void KonaneGame::make_move_(const KonaneMove &m_) {
+template <int N, int M> void BasicKonaneGame<N, M>::make_move_(const KonaneMove &m_) {
     KonaneMove m = m_;
 
     if (m.cf == KonaneCell(-1, -1)) {
@@ -171,10 +201,12 @@ void KonaneGame::make_move_(const KonaneMove &m_) {
             }
         }
     }
+
+    update_accumulators(get_enemy());
 }
 
 /* Returns a move inputed by the player. */
-optional<KonaneMove> KonaneGame::get_player_move_(const string &command) const {
+template <int N, int M> optional<KonaneMove> BasicKonaneGame<N, M>::get_player_move_(const string &command) const {
     int xi, yi, xf, yf;
 
     if (is_first_turn() or is_second_turn()) {
@@ -197,7 +229,7 @@ optional<KonaneMove> KonaneGame::get_player_move_(const string &command) const {
 }
 
 /* Returns all the current possible moves. */
-vector<KonaneMove> KonaneGame::get_moves_() const {
+template <int N, int M> vector<KonaneMove> BasicKonaneGame<N, M>::get_moves_() const {
     vector<KonaneMove> moves;
 
     if (is_first_turn() or is_second_turn()) {
@@ -205,7 +237,7 @@ vector<KonaneMove> KonaneGame::get_moves_() const {
     }
 
     for (int xi = 0; xi < N; xi++) {
-        for (int yi = 0; yi < N; yi++) {
+        for (int yi = 0; yi < M; yi++) {
             if (test(KonaneCell(xi, yi)) == get_player()) { // For every pawn of the current player.
                 for (int d = 0; d < 4; d++) {               // For every direction.
                     int xf = xi + 2 * DIR[0][d];
@@ -227,21 +259,93 @@ vector<KonaneMove> KonaneGame::get_moves_() const {
     return moves;
 }
 
+/* Returns the smallest of the states that are symmetric to the current one, and the symmetry that maps the current state into it. */
+template <int N, int M> pair<BasicKonaneState<N, M>, int> BasicKonaneGame<N, M>::get_canonical_state_() const {
+    int best_symmetry = 0;
+
+    // The most significant cell in which two symmetric boards differ decides which state is smaller.
+    for (int symmetry = SYMMETRY_STEP; symmetry < SYMMETRIES; symmetry += SYMMETRY_STEP) {
+        for (int p = N * M - 1; p >= 0; p--) {
+            int bit = (board >> convert_cell(get_symmetric_cell(convert_cell(p), symmetry))) & 1;
+            int best_bit = (board >> convert_cell(get_symmetric_cell(convert_cell(p), best_symmetry))) & 1;
+
+            if (bit != best_bit) {
+                best_symmetry = bit < best_bit ? symmetry : best_symmetry;
+                break;
+            }
+        }
+    }
+
+    if (best_symmetry == 0) {
+        return {get_state(), 0};
+    }
+
+    BoardType symmetric_board = 0;
+
+    for (int p = 0; p < N * M; p++) {
+        if ((board >> p) & 1) {
+            symmetric_board |= BoardType(1) << convert_cell(get_symmetric_cell(convert_cell(p), best_symmetry));
+        }
+    }
+
+    return {encode_state(symmetric_board), best_symmetry};
+}
+
+/* Returns the move mapped by the given symmetry. */
+template <int N, int M> KonaneMove BasicKonaneGame<N, M>::get_symmetric_move_(const KonaneMove &m, int symmetry) const {
+    return KonaneMove(get_symmetric_cell(m.ci, symmetry), get_symmetric_cell(m.cf, symmetry));
+}
+
+/* Returns the multiple jumps. Every move captures in Konane, so single jumps are the quiet ones. Starting moves remove a pawn and jump nothing. */
+template <int N, int M> vector<KonaneMove> BasicKonaneGame<N, M>::get_noisy_moves_() const {
+    vector<KonaneMove> moves;
+
+    for (const KonaneMove &m : get_moves()) {
+        if (m.cf != KonaneCell(-1, -1) and abs(m.cf.x - m.ci.x) + abs(m.cf.y - m.ci.y) > 2) {
+            moves.push_back(m);
+        }
+    }
+
+    return moves;
+}
+
+/* Returns a value between -1 and 1 indicating how probable it is for the first player to win (1.0) or the other player to win (-1.0). */
+template <int N, int M> double BasicKonaneGame<N, M>::evaluate_() const {
+    if (!network.is_loaded()) {
+        return BaseGame::evaluate_();
+    }
+
+    if (accumulators.empty()) {
+        return network.evaluate(get_network_inputs());
+    }
+
+#ifdef DEBUG
+    assert(accumulators.top().inputs == get_network_inputs());
+#endif
+
+    return network.evaluate(accumulators.top());
+}
+
 /* ---------- PUBLIC ---------- */
 
-KonaneGame::KonaneGame() {
-    board = (1ll << (N * N)) - 1; // All 36 cells are filled in with pawns. White starts.
+template <int N, int M> BasicKonaneGame<N, M>::BasicKonaneGame() {
+    board = FULL_BOARD; // All cells are filled in with pawns. White starts.
     set_player_(WHITE);
-    Game<KonaneState, KonaneMove>::initialize_game_();
+    BaseGame::initialize_game_();
 }
 
-KonaneGame::KonaneGame(const KonaneState &state) {
+template <int N, int M> BasicKonaneGame<N, M>::BasicKonaneGame(const KonaneState &state) {
     load_game_(state);
-    Game<KonaneState, KonaneMove>::initialize_game_();
+    BaseGame::initialize_game_();
+}
+
+/* Returns the inputs of the evaluation network. */
+template <int N, int M> bitset<BasicKonaneGame<N, M>::NETWORK_INPUTS> BasicKonaneGame<N, M>::get_network_inputs() const {
+    return encode_network_inputs(get_player());
 }
 
 /* Returns if the move (xi, yi) -> (xf, yf) is a valid move. */
-bool KonaneGame::is_valid_move(const KonaneMove &m_) const {
+template <int N, int M> bool BasicKonaneGame<N, M>::is_valid_move(const KonaneMove &m_) const {
     KonaneMove m = m_;
 
     if (m.cf == KonaneCell(-1, -1)) { // One of the two first moves.
@@ -309,25 +413,25 @@ bool KonaneGame::is_valid_move(const KonaneMove &m_) const {
 }
 
 /* Returns the board for printing. */
-KonaneGame::operator string() const {
+template <int N, int M> BasicKonaneGame<N, M>::operator string() const {
     vector<KonaneMove> moves = get_moves();
-    long long highlighted = 0;
+    BoardType highlighted = 0;
 
     // Marking all (xi, yi).
     for (const KonaneMove &move : moves) {
-        highlighted |= 1ll << (long long)convert_cell(move.ci);
+        highlighted |= BoardType(1) << convert_cell(move.ci);
     }
 
     string str = "       ";
 
-    for (int y = 0; y < N; y++) {
+    for (int y = 0; y < M; y++) {
         str += "   " + to_string(y) + "  ";
     }
 
     str += " \n";
     str += "       ";
 
-    for (int y = 0; y < N; y++) {
+    for (int y = 0; y < M; y++) {
         str += "______";
     }
 
@@ -337,18 +441,18 @@ KonaneGame::operator string() const {
     for (int x = 0; x < N; x++) {
         str += "       ";
 
-        for (int y = 0; y < N; y++) {
+        for (int y = 0; y < M; y++) {
             str += "|     ";
         }
 
         str += "|\n";
         str += "   " + to_string(x) + "   ";
 
-        for (int y = 0; y < N; y++) {
+        for (int y = 0; y < M; y++) {
             str += "|  ";
 
             if (test(KonaneCell(x, y)) == WHITE) {
-                if ((highlighted >> (long long)convert_cell(KonaneCell(x, y))) & 1ll) {
+                if ((highlighted >> convert_cell(KonaneCell(x, y))) & 1) {
                     str += COLOR_BRIGHT_MAGENTA;
                 } else {
                     str += COLOR_RED;
@@ -357,7 +461,7 @@ KonaneGame::operator string() const {
                 str += "W";
                 str += COLOR_WHITE;
             } else if (test(KonaneCell(x, y)) == BLACK) {
-                if ((highlighted >> (long long)convert_cell(KonaneCell(x, y))) & 1ll) {
+                if ((highlighted >> convert_cell(KonaneCell(x, y))) & 1) {
                     str += COLOR_MAGENTA;
                 } else {
                     str += COLOR_BLUE;
@@ -375,7 +479,7 @@ KonaneGame::operator string() const {
         str += "|\n";
         str += "       ";
 
-        for (int y = 0; y < N; y++) {
+        for (int y = 0; y < M; y++) {
             str += "|_____";
         }
 
@@ -383,4 +487,8 @@ KonaneGame::operator string() const {
     }
 
     return str;
-}
\ No newline at end of file
+}
+/* ---------- BOARD SIZES ---------- */
+
+template class BasicKonaneGame<6, 6>;
+template class BasicKonaneGame<8, 8>;
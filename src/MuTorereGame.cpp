@@ -3,6 +3,7 @@
 #include <cctype>
 #include <cstring>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -10,82 +11,155 @@
 
 #include <MuTorereGame.hpp>
 
+/* ---------- STATE ---------- */
+
+/* Reads a state written by serialize. Throws invalid_argument if it isn't a board with one empty cell and WHITE or BLACK to play. */
+MuTorereState MuTorereState::deserialize(const string &serialized_state) {
+    int state = stoi(serialized_state);
+
+    if (state < 0 or state >= 2 * MuTorereGame::ENCODED_BOARDS or MuTorereGame::BOARDS[state % MuTorereGame::ENCODED_BOARDS] == -1) {
+        throw invalid_argument("invalid MuTorere state " + serialized_state);
+    }
+
+    return MuTorereState(state);
+}
+
 /* ---------- PRIVATE ---------- */
 
-/* Returns the position which is empty. */
-int MuTorereGame::get_empty_position() {
-    for (int p = 0; p < N + 1; p++) {
-        if (board[p] == NONE) {
-            return p;
+/* Returns the state of the tables of a board with one empty cell. */
+constexpr int MuTorereGame::get_index(const int (&board_)[N + 1], int player) {
+    int empty = 0;
+
+    while (board_[empty] != NONE) {
+        empty++;
+    }
+
+    int index_ = (player == WHITE ? 0 : BOARD_STATES) + (empty << N);
+
+    for (int p = 0, bit = 0; p < N + 1; p++) {
+        if (p != empty) {
+            index_ |= (board_[p] == BLACK) << bit++;
         }
     }
 
-    assert(false);
-    return -1;
+    return index_;
 }
 
-/* ---------- PROTECTED ---------- */
-
-/* Returns the current game state converted to State. */
-MuTorereState MuTorereGame::get_state_() const {
+/* Returns the given board and player as an encoded state. */
+constexpr int MuTorereGame::encode(const int (&board_)[N + 1], int player) {
     int state = 0;
     int pow = 1;
 
     // Board.
     for (int i = 0; i < N + 1; i++) {
-        if (board[i] == WHITE) {
-            state += 0 * pow;
-        } else if (board[i] == BLACK) {
-            state += 1 * pow;
-        } else {
-            state += 2 * pow;
-        }
-
+        state += get_digit(board_[i]) * pow;
         pow *= 3;
     }
 
     // Current player.
-    if (get_player() == WHITE) {
-        state += 0 * pow;
-    } else if (get_player() == BLACK) {
-        state += 1 * pow;
-    } else {
-        state += 2 * pow;
+    return state + get_digit(player) * pow;
+}
+
+/* Returns true if the rules allow moving the piece in the given position in a state of the tables. */
+constexpr bool MuTorereGame::is_legal(int index_, int p) {
+    int player = get_index_player(index_);
+
+    if (get_cell(index_, p) != player) { // Can't move a pawn if it doesn't belong to the current player.
+        return false;
     }
 
-    return MuTorereState(state);
+    if (p == N) { // Can always move from the center.
+        return true;
+    }
+
+    int previous = get_cell(index_, (p + N - 1) % N);
+    int next = get_cell(index_, (p + 1) % N);
+
+    if (get_cell(index_, N) == NONE) { // Can move to the center if adjacent to an enemy.
+        return previous == -player or next == -player;
+    }
+
+    // Can move around the circle if adjacent to an empty space.
+    return previous == NONE or next == NONE;
 }
 
-/* Loads the game given a State. */
-void MuTorereGame::load_game_(const MuTorereState &state_) {
-    int state = state_.get();
+/* Computes the legal moves of every state and the states they lead to. */
+constexpr array<MuTorereGame::Transition, MuTorereGame::STATES> MuTorereGame::get_transitions() {
+    array<Transition, STATES> transitions = {};
 
-    // Board.
-    for (int i = 0; i < N + 1; i++) {
-        if (state % 3 == 0) {
-            board[i] = WHITE;
-        } else if (state % 3 == 1) {
-            board[i] = BLACK;
-        } else {
-            board[i] = NONE;
+    for (int index_ = 0; index_ < STATES; index_++) {
+        Transition &transition = transitions[index_];
+        int player = get_index_player(index_);
+        int empty = index_ % BOARD_STATES >> N;
+        int board_[N + 1] = {};
+
+        for (int p = 0; p < N + 1; p++) {
+            board_[p] = get_cell(index_, p);
         }
 
-        state /= 3;
+        transition.state = encode(board_, player);
+
+        for (int p = 0; p < N + 1; p++) {
+            if (is_legal(index_, p)) {
+                board_[p] = NONE, board_[empty] = player;
+                transition.pos[transition.moves] = p;
+                transition.next[transition.moves++] = get_index(board_, -player);
+                board_[p] = player, board_[empty] = NONE;
+            }
+        }
     }
 
-    // Current player.
-    if (state % 3 == 0) {
-        set_player_(WHITE);
-    } else if (state % 3 == 1) {
-        set_player_(BLACK);
-    } else {
-        set_player_(NONE);
+    return transitions;
+}
+
+/* Computes the state of the tables of every encoded board with WHITE to play. */
+constexpr array<int16_t, MuTorereGame::ENCODED_BOARDS> MuTorereGame::get_boards() {
+    array<int16_t, ENCODED_BOARDS> boards = {};
+
+    for (int code = 0; code < ENCODED_BOARDS; code++) {
+        int board_[N + 1] = {};
+        int empty_cells = 0;
+
+        for (int p = 0, digits = code; p < N + 1; p++, digits /= 3) {
+            board_[p] = digits % 3 == 0 ? WHITE : (digits % 3 == 1 ? BLACK : NONE);
+            empty_cells += board_[p] == NONE;
+        }
+
+        boards[code] = empty_cells == 1 ? get_index(board_, WHITE) : -1;
     }
+
+    return boards;
+}
+
+constexpr array<MuTorereGame::Transition, MuTorereGame::STATES> MuTorereGame::TRANSITIONS = MuTorereGame::get_transitions();
+constexpr array<int16_t, MuTorereGame::ENCODED_BOARDS> MuTorereGame::BOARDS = MuTorereGame::get_boards();
+
+/* ---------- PROTECTED ---------- */
+
+/* Returns the current game state converted to State. */
+MuTorereState MuTorereGame::get_state_() const {
+    return MuTorereState(TRANSITIONS[index].state);
 }
 
-/* Performs a move. Assumes that is_valid_move(m) is true. TODO: Remove assumption that is_valid_move(m) is true. */
+/* Loads the game given a State. */
+void MuTorereGame::load_game_(const MuTorereState &state_) {
+    int state = state_.get();
+    assert(BOARDS[state % ENCODED_BOARDS] != -1 and state / ENCODED_BOARDS < 2);
+
+    index = BOARDS[state % ENCODED_BOARDS] + state / ENCODED_BOARDS * BOARD_STATES;
+    set_player_(get_index_player(index));
+}
+
+/* Performs a move. Assumes that is_valid_move(m) is true. */
 void MuTorereGame::make_move_(const MuTorereMove &move) {
-    swap(board[move.pos], board[get_empty_position()]);
+    const Transition &transition = TRANSITIONS[index];
+
+    for (int i = 0; i < transition.moves; i++) {
+        if (transition.pos[i] == move.pos) {
+            index = transition.next[i];
+            return;
+        }
+    }
 }
 
 /* Returns a move inputed by the player. */
@@ -105,20 +179,55 @@ optional<MuTorereMove> MuTorereGame::get_player_move_(const string &command) con
 
 /* Returns all the possible moves for the current state of the game. */
 vector<MuTorereMove> MuTorereGame::get_moves_() const {
-    vector<MuTorereMove> moves;
+    const Transition &transition = TRANSITIONS[index];
+    return vector<MuTorereMove>(transition.pos, transition.pos + transition.moves);
+}
 
-    for (int p = 0; p < N + 1; p++) {
-        if (is_valid_move(MuTorereMove(p))) {
-            moves.push_back(MuTorereMove(p));
+/* Returns the smallest of the states that are symmetric to the current one, and the symmetry that maps the current state into it. */
+pair<MuTorereState, int> MuTorereGame::get_canonical_state_() const {
+    int best_symmetry = 0;
+
+    // The most significant position in which two symmetric boards differ decides which state is smaller. The center never differs.
+    for (int symmetry = 1; symmetry < SYMMETRIES; symmetry++) {
+        for (int p = N - 1; p >= 0; p--) {
+            int digit = get_digit(get_cell(index, get_symmetric_position(p, get_inverse_symmetry_(symmetry))));
+            int best_digit = get_digit(get_cell(index, get_symmetric_position(p, get_inverse_symmetry_(best_symmetry))));
+
+            if (digit != best_digit) {
+                best_symmetry = digit < best_digit ? symmetry : best_symmetry;
+                break;
+            }
         }
     }
 
-    return moves;
+    if (best_symmetry == 0) {
+        return {get_state(), 0};
+    }
+
+    int symmetric_board[N + 1];
+
+    for (int p = 0; p < N + 1; p++) {
+        symmetric_board[get_symmetric_position(p, best_symmetry)] = get_cell(index, p);
+    }
+
+    return {MuTorereState(encode(symmetric_board, get_player())), best_symmetry};
+}
+
+/* Returns the move mapped by the given symmetry. */
+MuTorereMove MuTorereGame::get_symmetric_move_(const MuTorereMove &m, int symmetry) const {
+    return MuTorereMove(get_symmetric_position(m.pos, symmetry));
+}
+
+/* Returns the symmetry that undoes the given symmetry. Reflections undo themselves. */
+int MuTorereGame::get_inverse_symmetry_(int symmetry) const {
+    return symmetry >= N ? symmetry : (N - symmetry) % N;
 }
 
 /* ---------- PUBLIC ---------- */
 
 MuTorereGame::MuTorereGame() {
+    int board[N + 1];
+
     for (int p = 0; p < N / 2; p++) {
         board[p] = WHITE;
     }
@@ -129,6 +238,7 @@ MuTorereGame::MuTorereGame() {
 
     board[N] = NONE;
 
+    index = get_index(board, WHITE);
     set_player_(WHITE);
     Game<MuTorereState, MuTorereMove>::initialize_game_();
 }
@@ -140,24 +250,8 @@ MuTorereGame::MuTorereGame(const MuTorereState &state) {
 
 /* Returns true if the movement is valid. */
 bool MuTorereGame::is_valid_move(const MuTorereMove &move) const {
-    if (move.pos < 0 or move.pos > N) { // Move out of bounds.
-        return false;
-    }
-
-    if (board[move.pos] != get_player()) { // Can't move a pawn if it doesn't belong to the current player.
-        return false;
-    }
-
-    if (move.pos == N) { // Can always move from the center.
-        return true;
-    }
-
-    if (board[N] == NONE) { // Can move to the center if adjacent to an enemy.
-        return board[(move.pos + N - 1) % N] == get_enemy() or board[(move.pos + 1) % N] == get_enemy();
-    }
-
-    // Can move around the circle if adjacent to an empty space.
-    return board[(move.pos + N - 1) % N] == NONE or board[(move.pos + 1) % N] == NONE;
+    const Transition &transition = TRANSITIONS[index];
+    return find(transition.pos, transition.pos + transition.moves, move.pos) != transition.pos + transition.moves;
 }
 
 MuTorereGame::operator string() const {
@@ -167,9 +261,9 @@ MuTorereGame::operator string() const {
     memset(c, ' ', sizeof(c));
 
     for (int p = 0; p < N + 1; p++) {
-        if (board[p] == WHITE) {
+        if (get_cell(index, p) == WHITE) {
             c[pos[p][0]][pos[p][1]] = is_valid_move(MuTorereMove(p)) ? 'W' : 'w';
-        } else if (board[p] == BLACK) {
+        } else if (get_cell(index, p) == BLACK) {
             c[pos[p][0]][pos[p][1]] = is_valid_move(MuTorereMove(p)) ? 'B' : 'b';
         } else {
             c[pos[p][0]][pos[p][1]] = '.';
@@ -9,81 +9,40 @@
 
 /* ---------- PRIVATE ---------- */
 
-bool TicTacToeGame::has_someone_won_() const {
-    int x, y;
-
-    // Checking rows.
-    for (x = 0; x < N; x++) {
-        if (board[x][0] != NONE) {
-            for (y = 1; y < N; y++) {
-                if (board[x][y] != board[x][0]) {
-                    break;
-                }
-            }
+/* Checks if a player has K in a row. */
+template <int N, int M, int K> bool BasicTicTacToeGame<N, M, K>::has_someone_won_() const {
+    int i;
 
-            if (y == N) {
-                return true;
-            }
-        }
-    }
+    for (const auto &line : LINES) {
+        int first = board[line[0][0]][line[0][1]];
 
-    // Checking columns.
-    for (y = 0; y < N; y++) {
-        if (board[0][y] != NONE) {
-            for (x = 1; x < N; x++) {
-                if (board[x][y] != board[0][y]) {
+        if (first != NONE) {
+            for (i = 1; i < K; i++) {
+                if (board[line[i][0]][line[i][1]] != first) {
                     break;
                 }
             }
 
-            if (x == N) {
+            if (i == K) {
                 return true;
             }
         }
     }
 
-    // Checking main diagonal.
-    if (board[0][0] != NONE) {
-        for (x = 1; x < N; x++) {
-            if (board[x][x] != board[0][0]) {
-                break;
-            }
-        }
-
-        if (x == N) {
-            return true;
-        }
-    }
-
-    // Checking secondary diagonal.
-    if (board[N - 1][0] != NONE) {
-        for (x = 1; x < N; x++) {
-            if (board[N - 1 - x][x] != board[N - 1][0]) {
-                break;
-            }
-        }
-
-        if (x == N) {
-            return true;
-        }
-    }
-
     return false;
 }
 
-/* ---------- PROTECTED ---------- */
-
-/* Returns the current game state converted to State. */
-TicTacToeState TicTacToeGame::get_state_() const {
-    int state = 0;
-    int pow = 1;
+/* Returns the given board and the rest of the current game state converted to State. */
+template <int N, int M, int K> TicTacToeState BasicTicTacToeGame<N, M, K>::encode_state(const int (&board_)[N][M]) const {
+    long long state = 0;
+    long long pow = 1;
 
     // Board.
     for (int x = 0; x < N; x++) {
-        for (int y = 0; y < N; y++) {
-            if (board[x][y] == CROSS) {
+        for (int y = 0; y < M; y++) {
+            if (board_[x][y] == CROSS) {
                 state += 0 * pow;
-            } else if (board[x][y] == CIRCLE) {
+            } else if (board_[x][y] == CIRCLE) {
                 state += 1 * pow;
             } else {
                 state += 2 * pow;
@@ -105,13 +64,20 @@ TicTacToeState TicTacToeGame::get_state_() const {
     return TicTacToeState(state);
 }
 
+/* ---------- PROTECTED ---------- */
+
+/* Returns the current game state converted to State. */
+template <int N, int M, int K> TicTacToeState BasicTicTacToeGame<N, M, K>::get_state_() const {
+    return encode_state(board);
+}
+
 /* Loads the game given a State. */
-void TicTacToeGame::load_game_(const TicTacToeState &state_) {
-    int state = state_.get();
+template <int N, int M, int K> void BasicTicTacToeGame<N, M, K>::load_game_(const TicTacToeState &state_) {
+    long long state = state_.get();
 
     // Board.
     for (int x = 0; x < N; x++) {
-        for (int y = 0; y < N; y++) {
+        for (int y = 0; y < M; y++) {
             if (state % 3 == 0) {
                 board[x][y] = CROSS;
             } else if (state % 3 == 1) {
@@ -135,12 +101,12 @@ void TicTacToeGame::load_game_(const TicTacToeState &state_) {
 }
 
 /* Performs a move. Assumes that is_valid_move(m) is true. TODO: Remove assumption that is_valid_move(m) is true. */
-void TicTacToeGame::make_move_(const TicTacToeMove &m_) {
+template <int N, int M, int K> void BasicTicTacToeGame<N, M, K>::make_move_(const TicTacToeMove &m_) {
     board[m_.c.x][m_.c.y] = get_player();
 }
 
 /* Returns a move inputed by the player. */
-optional<TicTacToeMove> TicTacToeGame::get_player_move_(const string &command) const {
+template <int N, int M, int K> optional<TicTacToeMove> BasicTicTacToeGame<N, M, K>::get_player_move_(const string &command) const {
     int x, y;
 
     if (sscanf(command.c_str(), "%d %d", &x, &y) != 2) {
@@ -155,7 +121,7 @@ optional<TicTacToeMove> TicTacToeGame::get_player_move_(const string &command) c
 }
 
 /* Returns all the current possible moves. */
-vector<TicTacToeMove> TicTacToeGame::get_moves_() const {
+template <int N, int M, int K> vector<TicTacToeMove> BasicTicTacToeGame<N, M, K>::get_moves_() const {
     vector<TicTacToeMove> moves;
 
     if (has_someone_won_()) {
@@ -163,7 +129,7 @@ vector<TicTacToeMove> TicTacToeGame::get_moves_() const {
     }
 
     for (int x = 0; x < N; x++) {
-        for (int y = 0; y < N; y++) {
+        for (int y = 0; y < M; y++) {
             if (is_valid_move(TicTacToeMove(x, y))) {
                 moves.push_back(TicTacToeMove(x, y));
             }
@@ -174,45 +140,75 @@ vector<TicTacToeMove> TicTacToeGame::get_moves_() const {
 }
 
 /* Returns the winner. */
-int TicTacToeGame::get_winner_() const {
+template <int N, int M, int K> int BasicTicTacToeGame<N, M, K>::get_winner_() const {
     if (has_someone_won_()) {
-        return Game<TicTacToeState, TicTacToeMove>::get_winner_();
+        return BaseGame::get_winner_();
     }
 
     return NONE;
 }
 
+/* Returns the smallest of the states that are symmetric to the current one, and the symmetry that maps the current state into it. */
+template <int N, int M, int K> pair<TicTacToeState, int> BasicTicTacToeGame<N, M, K>::get_canonical_state_() const {
+    int best_symmetry = get_smallest_board_symmetry<N, M, TicTacToeCell>(SYMMETRY_STEP, [&](int x, int y) { return get_digit(board[x][y]); });
+
+    if (best_symmetry == 0) {
+        return {get_state(), 0};
+    }
+
+    int symmetric_board[N][M];
+
+    for (int x = 0; x < N; x++) {
+        for (int y = 0; y < M; y++) {
+            TicTacToeCell c = get_symmetric_cell(TicTacToeCell(x, y), best_symmetry);
+            symmetric_board[c.x][c.y] = board[x][y];
+        }
+    }
+
+    return {encode_state(symmetric_board), best_symmetry};
+}
+
+/* Returns the move mapped by the given symmetry. */
+template <int N, int M, int K> TicTacToeMove BasicTicTacToeGame<N, M, K>::get_symmetric_move_(const TicTacToeMove &m, int symmetry) const {
+    return TicTacToeMove(get_symmetric_cell(m.c, symmetry));
+}
+
+/* Returns the symmetry that undoes the given symmetry. */
+template <int N, int M, int K> int BasicTicTacToeGame<N, M, K>::get_inverse_symmetry_(int symmetry) const {
+    return get_inverse_board_symmetry(symmetry);
+}
+
 /* ---------- PUBLIC ---------- */
 
-TicTacToeGame::TicTacToeGame() {
+template <int N, int M, int K> BasicTicTacToeGame<N, M, K>::BasicTicTacToeGame() {
     memset(board, NONE, sizeof(board));
     set_player_(CROSS);
-    Game<TicTacToeState, TicTacToeMove>::initialize_game_();
+    BaseGame::initialize_game_();
 }
 
-TicTacToeGame::TicTacToeGame(const TicTacToeState &state) {
+template <int N, int M, int K> BasicTicTacToeGame<N, M, K>::BasicTicTacToeGame(const TicTacToeState &state) {
     load_game_(state);
-    Game<TicTacToeState, TicTacToeMove>::initialize_game_();
+    BaseGame::initialize_game_();
 }
 
 /* Returns if the move (x, y) is a valid move. */
-bool TicTacToeGame::is_valid_move(const TicTacToeMove &m_) const {
+template <int N, int M, int K> bool BasicTicTacToeGame<N, M, K>::is_valid_move(const TicTacToeMove &m_) const {
     return is_inside(m_.c) and board[m_.c.x][m_.c.y] == NONE;
 }
 
 /* Returns the board for printing. */
-TicTacToeGame::operator string() const {
+template <int N, int M, int K> BasicTicTacToeGame<N, M, K>::operator string() const {
     string str;
 
     for (int x = 0; x < N; x++) {
-        for (int y = 0; y < N; y++) {
+        for (int y = 0; y < M; y++) {
             str += "     ";
-            str += y < N - 1 ? "|" : "";
+            str += y < M - 1 ? "|" : "";
         }
 
         str += "\n";
 
-        for (int y = 0; y < N; y++) {
+        for (int y = 0; y < M; y++) {
             str += "  ";
 
             if (board[x][y] == CROSS) {
@@ -224,18 +220,24 @@ TicTacToeGame::operator string() const {
             }
 
             str += "  ";
-            str += y < N - 1 ? "|" : "";
+            str += y < M - 1 ? "|" : "";
         }
 
         str += "\n";
 
-        for (int y = 0; y < N; y++) {
+        for (int y = 0; y < M; y++) {
             str += x < N - 1 ? "_____" : "     ";
-            str += y < N - 1 ? "|" : "";
+            str += y < M - 1 ? "|" : "";
         }
 
         str += "\n";
     }
 
     return str;
-}
\ No newline at end of file
+}
+
+/* ---------- BOARD SIZES ---------- */
+
+template class BasicTicTacToeGame<3, 3, 3>;
+template class BasicTicTacToeGame<4, 4, 4>;
+template class BasicTicTacToeGame<5, 5, 4>;
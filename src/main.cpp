@@ -3,23 +3,27 @@
 #include <chrono>
 #include <cstdio>
 #include <filesystem>
-#include <fstream>
-#include <iterator>
+#include <future>
 #include <optional>
+#include <thread>
+#include <tuple>
 #include <typeindex>
 #include <unordered_map>
 #include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
-#else
-#include <thread>
 #endif
 
 /* Common. */
 #include <Common.hpp>
 #include <Game.hpp>
+#include <MCTS.hpp>
 #include <Minimax.hpp>
+#include <Parameters.hpp>
+#include <ProofNumber.hpp>
+#include <Protocol.hpp>
+#include <SaveJournal.hpp>
 
 /* Games. */
 #include <BaghChalGame.hpp>
@@ -44,8 +48,16 @@ constexpr int PLAYER_VS_CPU = 2;
 constexpr int CPU_VS_PLAYER = 3;
 constexpr int CPU_VS_CPU = 4;
 
+/* Engine option constants. */
+constexpr int ENGINE_MINIMAX = 1;
+constexpr int ENGINE_MCTS = 2;
+constexpr int ENGINE_PROOF_NUMBER = 3;
+
 /* Constants. */
 const filesystem::path SAVES_FOLDER_PATH("./saves");
+const string PARAMETERS_PATH = "data/params.txt";
+const string NETWORKS_FOLDER_PATH = "data/";
+const string BOOKS_FOLDER_PATH = "data/";
 constexpr chrono::duration<long double> DEFAULT_TIMEOUT = 2.0s;
 constexpr int MAX_COMMAND_LENGTH = 128;
 
@@ -100,6 +112,26 @@ int get_game_mode() {
     return op;
 }
 
+/* Gets the engine used by the CPU. */
+int get_engine() {
+    int op;
+
+    printf("Select Engine:\n");
+    printf("(1) Minimax\n");
+    printf("(2) Monte Carlo Tree Search\n");
+    printf("(3) Proof-Number Search\n");
+
+    do {
+        printf("Engine: ");
+        scanf("%d", &op);
+        clear_input();
+    } while (op < ENGINE_MINIMAX or op > ENGINE_PROOF_NUMBER);
+
+    printf("\n");
+
+    return op;
+}
+
 /* Returns the format string to read a command from stdin. */
 string get_command_format_string() {
     return "%" + to_string(MAX_COMMAND_LENGTH) + "[^\n]";
@@ -159,25 +191,14 @@ template <class GameType, class MoveType = typename GameType::move_type> void pr
     printf("\n");
 }
 
-/* Returns filename given the game turn. */
-string get_filename(int turn) {
-    return string("turn") + to_string(turn) + ".dat";
-}
-
-/* Clears all game saves for a certain GameType. */
-template <class GameType> void clear_game_saves() {
-    // Getting path.
-    string game_name = GAME_NAME.at(type_index(typeid(GameType)));
-    filesystem::path saves_path = SAVES_FOLDER_PATH / game_name;
-
-    // Clearing folder.
-    filesystem::remove_all(saves_path);
+/* Returns the path of the save journal of a certain GameType. */
+template <class GameType> filesystem::path get_journal_path() {
+    return SAVES_FOLDER_PATH / (GAME_NAME.at(type_index(typeid(GameType))) + ".journal");
 }
 
 /* Loads or starts a new game. */
 template <class GameType, class StateType = typename GameType::state_type> GameType load_game() {
-    string game_name = GAME_NAME.at(type_index(typeid(GameType)));
-    filesystem::path save_path;
+    optional<SaveJournal::Record> record;
     int turn;
 
     do {
@@ -185,9 +206,8 @@ template <class GameType, class StateType = typename GameType::state_type> GameT
         scanf("%d", &turn);
         clear_input();
 
-        string filename = get_filename(turn);
-        save_path = SAVES_FOLDER_PATH / game_name / filename;
-    } while (turn != 0 and !filesystem::exists(save_path));
+        record = SaveJournal::read(get_journal_path<GameType>(), turn);
+    } while (turn != 0 and !record.has_value());
 
     printf("\n");
 
@@ -196,34 +216,47 @@ template <class GameType, class StateType = typename GameType::state_type> GameT
         return GameType();
     }
 
-    // Reading file.
-    ifstream file(save_path);
-    string serialized_game_state((istreambuf_iterator<char>(file)), (istreambuf_iterator<char>()));
+    return GameType(StateType::deserialize(record->get_state()));
+}
+
+/* Returns the index of the move that led to the current state among the moves of the previous state, or SaveJournal::NO_MOVE. */
+template <class GameType> int get_last_move_index(const GameType &game) {
+    if (game.get_turn() < 2) {
+        return SaveJournal::NO_MOVE;
+    }
+
+    GameType previous = game;
+    previous.rollback();
+    const auto moves = previous.get_moves();
+
+    for (int i = 0; i < moves.size(); i++) {
+        previous.make_move(moves[i]);
+        bool found = previous.get_state() == game.get_state();
+        previous.rollback();
+
+        if (found) {
+            return i;
+        }
+    }
 
-    return GameType(StateType::deserialize(serialized_game_state));
+    return SaveJournal::NO_MOVE;
 }
 
-/* Auto-saves game state into a file. */
-template <class GameType> void save_game(const GameType &game) {
-    // Getting path.
-    string game_name = GAME_NAME.at(type_index(typeid(GameType)));
-    string filename = get_filename(game.get_turn());
-    filesystem::path save_path = SAVES_FOLDER_PATH / game_name / filename;
-
-    // Writing to file.
-    filesystem::create_directories(save_path.parent_path());
-    ofstream file(save_path);
-    file << game.get_state().serialize();
+/* Auto-saves game state into the journal. */
+template <class GameType> void save_game(const GameType &game, SaveJournal &journal) {
+    if (!journal.append(game.get_turn(), game.get_state().serialize(), get_last_move_index(game))) {
+        printf(COLOR_YELLOW "Could not save turn %d.\n" COLOR_WHITE, game.get_turn());
+    }
 }
 
 /* Prints what should be printed every iteration of the game loop. */
-template <class GameType> void game_loop_print(const GameType &game) {
+template <class GameType> void game_loop_print(const GameType &game, SaveJournal &journal) {
     // Printing the board.
     printf(COLOR_BRIGHT_BLACK "\n========== TURN %03d ==========\n\n" COLOR_WHITE, game.get_turn());
     printf("%s\n", string(game).c_str());
 
     // Saving the board.
-    save_game(game);
+    save_game(game, journal);
 
     // Printing possible moves.
     print_possible_moves(game);
@@ -386,15 +419,32 @@ template <class GameType, class MoveType = typename GameType::move_type> optiona
     return move.value();
 }
 
-/* Returns a move given by the AI. */
-template <class GameType, class MoveType = typename GameType::move_type>
-MoveType get_ai_move(const GameType &game, Minimax<GameType> &ai, chrono::duration<long double> timeout = DEFAULT_TIMEOUT) {
-    typename Minimax<GameType>::OptimalMove ans;
-    int depth;
+/* Returns the result of a search of the engine given a time limit. */
+template <class GameType, class EngineType> auto search_move(const GameType &game, EngineType &ai, chrono::duration<long double> timeout) {
+    return ai.get_move(game, timeout);
+}
 
-    // Getting optimal move.
+/* Returns the result of a Minimax search given a time limit, stopping it if it is still searching after twice that time. */
+template <class GameType> auto search_move(const GameType &game, Minimax<GameType> &ai, chrono::duration<long double> timeout) {
+    typename Minimax<GameType>::Limits limits;
+    limits.timeout = timeout;
+    typename Minimax<GameType>::AsyncSearch search = ai.start_search(game, limits);
+
+    if (search.get_future().wait_for(2.0 * timeout) == future_status::timeout) {
+        search.stop();
+    }
+
+    return search.get_future().get();
+}
+
+/* Returns a move given by the AI. */
+template <class GameType, class EngineType, class MoveType = typename GameType::move_type>
+MoveType get_ai_move(const GameType &game, EngineType &ai, chrono::duration<long double> timeout = DEFAULT_TIMEOUT) {
+    // Getting optimal move. Minimax also returns statistics of its search.
     chrono::time_point<chrono::high_resolution_clock> t_start = chrono::high_resolution_clock::now();
-    tie(ans, depth) = ai.get_move(game, timeout);
+    auto result = search_move(game, ai, timeout);
+    const typename EngineType::OptimalMove &ans = get<0>(result);
+    int depth = get<1>(result);
     chrono::duration<long double> t = chrono::high_resolution_clock::now() - t_start;
 
 // Pretending that the AI is thinking for at least timeout milliseconds.
@@ -407,11 +457,11 @@ MoveType get_ai_move(const GameType &game, Minimax<GameType> &ai, chrono::durati
     // Printing move.
     printf("%s\n", string(ans.move).c_str());
 
-    string score_color = ans.score == 0.0 ? COLOR_YELLOW : (ans.score > 0.0 ? COLOR_RED : COLOR_BLUE);
+    string score_color = ans.score == 0 ? COLOR_YELLOW : (ans.score > 0 ? COLOR_RED : COLOR_BLUE);
     string thinking_time_color = t <= timeout ? COLOR_GREEN : (t <= 2.0 * timeout ? COLOR_YELLOW : COLOR_RED);
 
     // Printing thinking time.
-    printf("(%sscore = %.3lf" COLOR_WHITE " / %stime = %.3Lfs" COLOR_WHITE " / depth = %d) ", score_color.c_str(), ans.score, thinking_time_color.c_str(),
+    printf("(%sscore = %.3lf" COLOR_WHITE " / %stime = %.3Lfs" COLOR_WHITE " / depth = %d) ", score_color.c_str(), ans.evaluation(), thinking_time_color.c_str(),
            t.count(), depth);
 
     // Printing if the AI is playing optimally or not.
@@ -432,6 +482,11 @@ MoveType get_ai_move(const GameType &game, Minimax<GameType> &ai, chrono::durati
         }
     }
 
+    // Printing search statistics.
+    if constexpr (tuple_size_v<decltype(result)> > 2) {
+        printf("(%s)\n", get<2>(result).summary().c_str());
+    }
+
     printf("\n");
 
     return ans.move;
@@ -440,18 +495,27 @@ MoveType get_ai_move(const GameType &game, Minimax<GameType> &ai, chrono::durati
 /* Game loop. */
 template <class GameType, class MoveType = typename GameType::move_type> void game_loop() {
     // Initializing.
-    Minimax<GameType> ai;
+    typename MCTS<GameType>::Settings mcts_settings;
+    mcts_settings.threads = max(1u, thread::hardware_concurrency());
+
+    Minimax<GameType> minimax;
+    MCTS<GameType> mcts(mcts_settings);
+    ProofNumber<GameType> proof_number;
     int game_mode = get_game_mode();
+    int engine = game_mode == PLAYER_VS_PLAYER ? ENGINE_MINIMAX : get_engine();
     GameType game = load_game<GameType>();
+    SaveJournal journal;
 
-    // Clearing old saves.
-    clear_game_saves<GameType>();
+    // Replacing old saves.
+    if (!journal.create(get_journal_path<GameType>())) {
+        printf(COLOR_YELLOW "Could not create %s, the game won't be saved.\n" COLOR_WHITE, get_journal_path<GameType>().string().c_str());
+    }
 
     do {
         // Game loop.
         while (!game.is_game_over()) {
             // Printing the current state of the game.
-            game_loop_print(game);
+            game_loop_print(game, journal);
 
             // Move input.
             if (is_player_turn(game, game_mode)) { // Human.
@@ -460,8 +524,12 @@ template <class GameType, class MoveType = typename GameType::move_type> void ga
                 if (move.has_value()) {
                     game.make_move(move.value());
                 }
-            } else { // CPU.
-                game.make_move(get_ai_move(game, ai));
+            } else if (engine == ENGINE_MINIMAX) { // CPU.
+                game.make_move(get_ai_move(game, minimax));
+            } else if (engine == ENGINE_MCTS) {
+                game.make_move(get_ai_move(game, mcts));
+            } else {
+                game.make_move(get_ai_move(game, proof_number));
             }
         }
 
@@ -470,8 +538,25 @@ template <class GameType, class MoveType = typename GameType::move_type> void ga
     } while (continue_playing(game, game_mode));
 }
 
-int main() {
+/* Usage: main [--protocol] */
+int main(int argc, char *argv[]) {
     // Initializing.
+    Parameters::load(PARAMETERS_PATH);
+    BaghChalGame::network.load(NETWORKS_FOLDER_PATH + "BaghChal.nn");
+    KonaneGame::network.load(NETWORKS_FOLDER_PATH + "Konane.nn");
+    Minimax<KonaneGame>::book.load(BOOKS_FOLDER_PATH + "Konane.book");
+    Minimax<MuTorereGame>::book.load(BOOKS_FOLDER_PATH + "MuTorere.book");
+    Minimax<BaghChalGame>::book.load(BOOKS_FOLDER_PATH + "BaghChal.book");
+    Minimax<TicTacToeGame>::book.load(BOOKS_FOLDER_PATH + "TicTacToe.book");
+    Minimax<ConnectFourGame>::book.load(BOOKS_FOLDER_PATH + "ConnectFour.book");
+
+    // Serving other programs instead of a human.
+    if (argc > 1 and string(argv[1]) == "--protocol") {
+        Protocol protocol;
+        protocol.run();
+        return 0;
+    }
+
     printf(COLOR_WHITE);
 
     // Choosing game to play.
@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Common. */
+#include <Game.hpp>
+#include <Minimax.hpp>
+#include <Parameters.hpp>
+#include <ProofNumber.hpp>
+
+/* Games. */
+#include <BaghChalGame.hpp>
+#include <ConnectFourGame.hpp>
+#include <KonaneGame.hpp>
+#include <MuTorereGame.hpp>
+#include <TicTacToeGame.hpp>
+
+using namespace std;
+
+/* Constants. */
+const string POSITIONS_FOLDER_PATH = "data/positions/";
+const string PARAMETERS_PATH = "data/params.txt";
+const string NETWORKS_FOLDER_PATH = "data/";
+constexpr int DEFAULT_DEPTH = 6;
+constexpr double DEFAULT_PROOF_NUMBER_TIME = 10.0;
+
+/* Command line options. */
+class Options {
+  public:
+    string game_name;
+    string positions_path;
+    string engine = "minimax"; // minimax or pns.
+    optional<int> depth = nullopt;
+    optional<double> time = nullopt;
+    int threads = max(1u, thread::hardware_concurrency());
+    optional<size_t> tt = nullopt;
+    bool shared_tt = false;
+    string tt_file;
+    bool tt_read_only = false;
+    int multi_pv = 1;
+};
+
+/* Result of analyzing a single position. */
+class PositionResult {
+  public:
+    string move, winner;
+    double score;
+    int depth;
+    long long nodes;
+    double time;
+    vector<string> lines; // Rows of the moves after the best one, with Options::multi_pv > 1.
+};
+
+/* Returns the winner of a solved position as text. */
+template <class GameType> string get_winner(const optional<int> &winner) {
+    if (!winner.has_value()) {
+        return "-";
+    }
+
+    if (winner.value() == GameType::PLAYER_MAX) {
+        return "max";
+    }
+
+    if (winner.value() == GameType::PLAYER_MIN) {
+        return "min";
+    }
+
+    return "draw";
+}
+
+/* Solves a position with proof-number search. The best move and the depth are those of the solved line, and unsolved positions have no move. */
+template <class GameType>
+PositionResult solve_position(ProofNumber<GameType> &solver, const GameType &game, const typename ProofNumber<GameType>::Limits &limits) {
+    chrono::time_point<chrono::high_resolution_clock> t_start = chrono::high_resolution_clock::now();
+    typename ProofNumber<GameType>::Result result = solver.solve(game, limits);
+    chrono::duration<double> t = chrono::high_resolution_clock::now() - t_start;
+
+    if (!result.winner.has_value() or result.principal_variation.empty()) {
+        return {"-", get_winner<GameType>(result.winner), 0.0, 0, result.nodes, t.count(), {}};
+    }
+
+    int depth = result.principal_variation.size(), turn = game.get_turn() + depth;
+    int score = Minimax<GameType>::terminal_score(result.winner.value(), turn);
+    typename Minimax<GameType>::OptimalMove ans(result.principal_variation[0], score, result.winner, turn);
+    return {string(ans.move), get_winner<GameType>(ans.winner), ans.evaluation(), depth, result.nodes, t.count(), {}};
+}
+
+/* Analyzes every position of the file on a pool of threads with one Minimax or proof-number solver each. Positions are read as they are needed,
+   and results are printed in the order of the file as soon as every position before them is done. */
+template <class GameType, class StateType = typename GameType::state_type> void analyze_positions(const Options &options) {
+    typename Minimax<GameType>::Settings settings;
+    typename Minimax<GameType>::Limits limits;
+    limits.depth = options.depth;
+
+    if (options.time.has_value()) {
+        limits.timeout = chrono::duration<long double>(options.time.value());
+    } else if (!options.depth.has_value()) {
+        limits.depth = DEFAULT_DEPTH;
+    }
+
+    if (options.tt.has_value()) {
+        settings.transposition_table_megabytes = options.tt.value();
+    }
+
+    settings.multi_pv = options.multi_pv;
+    settings.transposition_table_path = options.tt_file;
+    settings.transposition_table_read_only = options.tt_read_only;
+    shared_ptr<TranspositionTable> shared_table = nullptr;
+    bool proof_number = options.engine == "pns";
+
+    // Proof-number search only takes a time limit.
+    typename ProofNumber<GameType>::Limits proof_number_limits;
+    proof_number_limits.timeout = chrono::duration<long double>(options.time.value_or(DEFAULT_PROOF_NUMBER_TIME));
+
+    // The threads map a table file once, sharing it.
+    if (!proof_number and (options.shared_tt or !options.tt_file.empty())) {
+        shared_table = Minimax<GameType>::make_transposition_table(settings);
+
+        if (!options.tt_file.empty() and !shared_table->is_file_backed()) {
+            fprintf(stderr, "Could not map %s, the transposition table won't be kept\n", options.tt_file.c_str());
+        }
+    }
+
+    ifstream file(options.positions_path);
+
+    if (!file) {
+        fprintf(stderr, "Could not open %s\n", options.positions_path.c_str());
+        return;
+    }
+
+    mutex input_mutex, output_mutex;
+    int next_input = 0, next_output = 0;
+    map<int, PositionResult> pending; // Results waiting for the ones before them.
+    long long total_nodes = 0;
+
+    // Returns the next position of the file and its index, or nullopt at the end of the file.
+    auto read_position = [&]() -> optional<pair<int, string>> {
+        lock_guard<mutex> lock(input_mutex);
+        string serialized_state;
+
+        while (getline(file, serialized_state)) {
+            if (!serialized_state.empty() and serialized_state.back() == '\r') {
+                serialized_state.pop_back();
+            }
+
+            if (!serialized_state.empty()) {
+                return make_pair(next_input++, serialized_state);
+            }
+        }
+
+        return nullopt;
+    };
+
+    auto worker = [&]() {
+        unique_ptr<Minimax<GameType>> ai = proof_number ? nullptr : make_unique<Minimax<GameType>>(settings, shared_table);
+        ProofNumber<GameType> solver;
+
+        for (optional<pair<int, string>> position = read_position(); position.has_value(); position = read_position()) {
+            GameType game(StateType::deserialize(position->second));
+            PositionResult result;
+
+            if (game.is_game_over()) {
+                result = {"none", get_winner<GameType>(game.get_winner()), 0.0, 0, 0, 0.0, {}};
+            } else if (proof_number) {
+                // Results of other positions are forgotten too, as in Minimax.
+                solver.clear();
+                result = solve_position(solver, game, proof_number_limits);
+            } else {
+                // Every position starts from an empty Minimax, so results don't depend on which thread searched it, unless the table is shared.
+                ai->clear();
+
+                chrono::time_point<chrono::high_resolution_clock> t_start = chrono::high_resolution_clock::now();
+                auto [ans, reached_depth, statistics] = ai->get_move(game, limits);
+                chrono::duration<double> t = chrono::high_resolution_clock::now() - t_start;
+
+                result = {string(ans.move), get_winner<GameType>(ans.winner), ans.evaluation(), reached_depth, statistics.nodes, t.count(), {}};
+
+                for (int i = 1; i < ai->get_lines().size(); i++) {
+                    const typename Minimax<GameType>::OptimalMove &line = ai->get_lines()[i].ans;
+                    char buffer[256];
+                    snprintf(buffer, sizeof(buffer), "  %-4s %-20s %10.6lf %s", (to_string(i + 1) + ".").c_str(), string(line.move).c_str(), line.evaluation(),
+                             get_winner<GameType>(line.winner).c_str());
+                    result.lines.push_back(buffer);
+                }
+            }
+
+            lock_guard<mutex> lock(output_mutex);
+            pending[position->first] = result;
+
+            for (auto it = pending.begin(); it != pending.end() and it->first == next_output; it = pending.erase(it)) {
+                const PositionResult &ready = it->second;
+                printf("%-6d %-20s %10.6lf %-6s %5d %12lld %8.3lfs\n", ++next_output, ready.move.c_str(), ready.score, ready.winner.c_str(), ready.depth,
+                       ready.nodes, ready.time);
+                total_nodes += ready.nodes;
+
+                for (const string &line : ready.lines) {
+                    printf("%s\n", line.c_str());
+                }
+            }
+
+            fflush(stdout);
+        }
+    };
+
+    printf("%-6s %-20s %10s %-6s %5s %12s %9s\n", "#", "Move", "Score", "Winner", "Depth", "Nodes", "Time");
+
+    chrono::time_point<chrono::high_resolution_clock> t_start = chrono::high_resolution_clock::now();
+    vector<thread> threads;
+
+    for (int i = 0; i < options.threads; i++) {
+        threads.emplace_back(worker);
+    }
+
+    for (thread &t : threads) {
+        t.join();
+    }
+
+    chrono::duration<double> t = chrono::high_resolution_clock::now() - t_start;
+    printf("Analyzed %d positions on %d threads in %.3lfs (%.1lf positions/s, %.0lf nodes/s)\n", next_output, options.threads, t.count(),
+           t.count() > 0.0 ? next_output / t.count() : 0.0, t.count() > 0.0 ? total_nodes / t.count() : 0.0);
+}
+
+/* Usage: analyze <game> [<positions file>] [--engine minimax|pns] [--depth <plies>] [--time <seconds>] [--threads <n>] [--tt <megabytes>]
+                  [--shared-tt] [--tt-file <file> [--tt-read-only]] [--multipv <n>] */
+int main(int argc, char *argv[]) {
+    Options options;
+    bool valid = argc > 1;
+
+    for (int i = 1; i < argc and valid; i++) {
+        string arg = argv[i];
+
+        if (arg == "--engine" and i + 1 < argc) {
+            options.engine = argv[++i];
+            valid = options.engine == "minimax" or options.engine == "pns";
+        } else if (arg == "--depth" and i + 1 < argc) {
+            options.depth = max(1, atoi(argv[++i]));
+        } else if (arg == "--time" and i + 1 < argc) {
+            options.time = atof(argv[++i]);
+        } else if (arg == "--threads" and i + 1 < argc) {
+            options.threads = max(1, atoi(argv[++i]));
+        } else if (arg == "--tt" and i + 1 < argc) {
+            options.tt = max(1ll, atoll(argv[++i]));
+        } else if (arg == "--shared-tt") {
+            options.shared_tt = true;
+        } else if (arg == "--tt-file" and i + 1 < argc) {
+            options.tt_file = argv[++i];
+        } else if (arg == "--tt-read-only") {
+            options.tt_read_only = true;
+        } else if (arg == "--multipv" and i + 1 < argc) {
+            options.multi_pv = max(1, atoi(argv[++i]));
+        } else if (arg.rfind("--", 0) == 0) {
+            valid = false;
+        } else if (options.game_name.empty()) {
+            options.game_name = arg;
+        } else if (options.positions_path.empty()) {
+            options.positions_path = arg;
+        } else {
+            valid = false;
+        }
+    }
+
+    if (!valid) {
+        printf("Usage: analyze <game> [<positions file>] [--engine minimax|pns] [--depth <plies>] [--time <seconds>] [--threads <n>] [--tt <megabytes>]\n");
+        printf("               [--shared-tt] [--tt-file <file> [--tt-read-only]] [--multipv <n>]\n");
+        return 1;
+    }
+
+    if (options.positions_path.empty()) {
+        options.positions_path = POSITIONS_FOLDER_PATH + options.game_name + ".txt";
+    }
+
+    Parameters::load(PARAMETERS_PATH);
+    BaghChalGame::network.load(NETWORKS_FOLDER_PATH + "BaghChal.nn");
+    KonaneGame::network.load(NETWORKS_FOLDER_PATH + "Konane.nn");
+
+    if (options.game_name == "Konane") {
+        analyze_positions<KonaneGame>(options);
+    } else if (options.game_name == "MuTorere") {
+        analyze_positions<MuTorereGame>(options);
+    } else if (options.game_name == "BaghChal") {
+        analyze_positions<BaghChalGame>(options);
+    } else if (options.game_name == "TicTacToe") {
+        analyze_positions<TicTacToeGame>(options);
+    } else if (options.game_name == "ConnectFour") {
+        analyze_positions<ConnectFourGame>(options);
+    } else {
+        printf("Unknown game %s\n", options.game_name.c_str());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,459 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Common. */
+#include <Game.hpp>
+#include <MCTS.hpp>
+#include <Minimax.hpp>
+#include <Parameters.hpp>
+
+/* Games. */
+#include <BaghChalGame.hpp>
+#include <ConnectFourGame.hpp>
+#include <KonaneGame.hpp>
+#include <MuTorereGame.hpp>
+#include <TicTacToeGame.hpp>
+
+using namespace std;
+
+/* Constants. */
+const string PARAMETERS_PATH = "data/params.txt";
+const string NETWORKS_FOLDER_PATH = "data/";
+const string BOOKS_FOLDER_PATH = "data/";
+
+/* Result constants, from the point of view of the first engine. */
+constexpr int WIN = 0;
+constexpr int DRAW = 1;
+constexpr int LOSS = 2;
+
+/* Engine configuration given as a comma separated list of key=value pairs. */
+class EngineOptions {
+  public:
+    bool mcts = false;                      // engine=<minimax|mcts>
+    optional<double> time = nullopt;        // time=<seconds per move>
+    optional<int> depth = nullopt;          // depth=<plies> (Minimax)
+    optional<long long> playouts = nullopt; // playouts=<playouts per move> (MCTS)
+    int threads = 1;                        // threads=<n> (MCTS)
+    bool persistent = true;                 // persistent=<0|1>
+    optional<size_t> tt = nullopt;          // tt=<transposition table megabytes> (Minimax)
+    int reductions = 0;                     // lmr=<plies>, 0 for none (Minimax)
+    bool extensions = false;                // extensions=<0|1> (Minimax)
+    bool quiescence = true;                 // quiescence=<0|1> (Minimax)
+    bool book = true;                       // book=<0|1> (Minimax)
+};
+
+/* Command line options. */
+class Options {
+  public:
+    string game_name;
+    EngineOptions engines[2];
+    int games = 100;
+    int concurrency = 1;
+    optional<string> openings = nullopt;
+    string parameters = PARAMETERS_PATH;
+    int random_plies = 4;
+    int max_turns = 200;
+    unsigned int seed = 0;
+    bool sprt = false;
+    double elo0 = 0.0, elo1 = 10.0, alpha = 0.05, beta = 0.05;
+};
+
+/* Match statistics. Time is wall time, so MCTS engines with several threads use proportionally more CPU. */
+class Statistics {
+  public:
+    long long results[3] = {0, 0, 0}; // Wins, draws and losses of the first engine.
+    long long moves[2] = {0, 0};      // Moves made by each engine.
+    double time[2] = {0.0, 0.0};      // Seconds spent by each engine.
+
+    long long games() const {
+        return results[WIN] + results[DRAW] + results[LOSS];
+    }
+
+    /* Average score of the first engine. */
+    double score() const {
+        return (results[WIN] + 0.5 * results[DRAW]) / games();
+    }
+
+    /* Variance of the score of a single game. */
+    double variance() const {
+        double mean = score();
+        return (results[WIN] * pow(1.0 - mean, 2.0) + results[DRAW] * pow(0.5 - mean, 2.0) + results[LOSS] * pow(mean, 2.0)) / games();
+    }
+};
+
+/* Returns the Elo difference that corresponds to the given expected score. */
+double elo(double score) {
+    score = clamp(score, 1e-6, 1.0 - 1e-6);
+    return -400.0 * log10(1.0 / score - 1.0);
+}
+
+/* Returns the expected score that corresponds to the given Elo difference. */
+double expected_score(double elo_difference) {
+    return 1.0 / (1.0 + pow(10.0, -elo_difference / 400.0));
+}
+
+/* Returns the log-likelihood ratio of H1 (elo1) against H0 (elo0) under the normal approximation of the trinomial distribution. */
+double log_likelihood_ratio(const Statistics &statistics, double elo0, double elo1) {
+    if (statistics.games() == 0 or statistics.variance() == 0.0) {
+        return 0.0;
+    }
+
+    double s0 = expected_score(elo0);
+    double s1 = expected_score(elo1);
+    return (s1 - s0) * (2.0 * statistics.score() - s0 - s1) * statistics.games() / (2.0 * statistics.variance());
+}
+
+/* Parses an engine configuration. Returns nullopt if it is invalid. */
+optional<EngineOptions> parse_engine(const string &str) {
+    EngineOptions engine;
+    stringstream ss(str);
+    string pair;
+
+    while (getline(ss, pair, ',')) {
+        size_t pos = pair.find('=');
+
+        if (pos == string::npos) {
+            return nullopt;
+        }
+
+        string key = pair.substr(0, pos);
+        string value = pair.substr(pos + 1);
+
+        if (key == "engine" and (value == "minimax" or value == "mcts")) {
+            engine.mcts = value == "mcts";
+        } else if (key == "time") {
+            engine.time = atof(value.c_str());
+        } else if (key == "depth") {
+            engine.depth = atoi(value.c_str());
+        } else if (key == "playouts") {
+            engine.playouts = atoll(value.c_str());
+        } else if (key == "threads") {
+            engine.threads = max(1, atoi(value.c_str()));
+        } else if (key == "persistent") {
+            engine.persistent = atoi(value.c_str()) != 0;
+        } else if (key == "tt") {
+            engine.tt = atoll(value.c_str());
+        } else if (key == "lmr") {
+            engine.reductions = max(0, atoi(value.c_str()));
+        } else if (key == "extensions") {
+            engine.extensions = atoi(value.c_str()) != 0;
+        } else if (key == "quiescence") {
+            engine.quiescence = atoi(value.c_str()) != 0;
+        } else if (key == "book") {
+            engine.book = atoi(value.c_str()) != 0;
+        } else {
+            return nullopt;
+        }
+    }
+
+    if (engine.mcts ? !engine.time.has_value() and !engine.playouts.has_value() : !engine.time.has_value() and !engine.depth.has_value()) {
+        return nullopt;
+    }
+
+    return engine;
+}
+
+/* Minimax or MCTS, configured by EngineOptions. */
+template <class GameType> class Engine {
+  private:
+    using MoveType = typename GameType::move_type;
+
+    EngineOptions options;
+    optional<Minimax<GameType>> minimax = nullopt;
+    optional<MCTS<GameType>> mcts = nullopt;
+
+  public:
+    Engine(const EngineOptions &options_) : options(options_) {
+        if (options.mcts) {
+            typename MCTS<GameType>::Settings settings;
+            settings.threads = options.threads;
+            settings.persistent = options.persistent;
+            mcts.emplace(settings);
+        } else {
+            typename Minimax<GameType>::Settings settings;
+            settings.persistent = options.persistent;
+            settings.late_move_reductions = options.reductions > 0;
+            settings.reduction = max(1, options.reductions);
+            settings.single_reply_extensions = settings.forcing_move_extensions = options.extensions;
+            settings.quiescence = options.quiescence;
+            settings.opening_book = options.book;
+
+            if (options.tt.has_value()) {
+                settings.transposition_table_megabytes = options.tt.value();
+            }
+
+            minimax.emplace(settings);
+        }
+    }
+
+    /* Forgets previous searches. */
+    void clear() {
+        if (options.mcts) {
+            mcts->clear();
+        } else {
+            minimax->clear();
+        }
+    }
+
+    /* Returns the move of the engine. */
+    MoveType get_move(const GameType &game) {
+        optional<chrono::duration<long double>> timeout = nullopt;
+
+        if (options.time.has_value()) {
+            timeout = chrono::duration<long double>(options.time.value());
+        }
+
+        if (options.mcts) {
+            typename MCTS<GameType>::Limits limits;
+            limits.timeout = timeout;
+            limits.playouts = options.playouts;
+            return mcts->get_move(game, limits).first.move;
+        }
+
+        typename Minimax<GameType>::Limits limits;
+        limits.timeout = timeout;
+        limits.depth = options.depth;
+        return get<0>(minimax->get_move(game, limits)).move;
+    }
+};
+
+/* Returns the starting position of the given opening pair. Both games of a pair start from the same position with colors swapped. */
+template <class GameType, class StateType = typename GameType::state_type, class MoveType = typename GameType::move_type>
+GameType get_opening(const Options &options, const vector<string> &openings, int pair_index) {
+    if (!openings.empty()) {
+        return GameType(StateType::deserialize(openings[pair_index % openings.size()]));
+    }
+
+    mt19937 rng(options.seed + pair_index);
+    GameType game;
+
+    for (int i = 0; i < options.random_plies and !game.is_game_over(); i++) {
+        const vector<MoveType> moves = game.get_moves();
+        game.make_move(moves[rng() % moves.size()]);
+    }
+
+    // Starting over in the unlikely case that the random moves ended the game.
+    return game.is_game_over() ? GameType() : game;
+}
+
+/* Plays games until there are no more games to play or the SPRT has finished. */
+template <class GameType>
+void play_games(const Options &options, const vector<string> &openings, atomic<int> &next_game, atomic<bool> &finished, Statistics &statistics,
+                mutex &statistics_mutex) {
+    Engine<GameType> engines[2] = {Engine<GameType>(options.engines[0]), Engine<GameType>(options.engines[1])};
+
+    for (int game_index = next_game++; game_index < options.games and !finished; game_index = next_game++) {
+        // Engine 0 plays PLAYER_MAX in even games and PLAYER_MIN in odd games.
+        int max_engine = game_index % 2;
+        GameType game = get_opening<GameType>(options, openings, game_index / 2);
+        Statistics game_statistics;
+
+        engines[0].clear();
+        engines[1].clear();
+
+        while (!game.is_game_over() and game.get_turn() < options.max_turns) {
+            int engine = game.get_player() == GameType::PLAYER_MAX ? max_engine : 1 - max_engine;
+
+            chrono::time_point<chrono::high_resolution_clock> t_start = chrono::high_resolution_clock::now();
+            typename GameType::move_type move = engines[engine].get_move(game);
+            chrono::duration<double> t = chrono::high_resolution_clock::now() - t_start;
+
+            game_statistics.moves[engine]++;
+            game_statistics.time[engine] += t.count();
+            game.make_move(move);
+        }
+
+        // Games that are too long are adjudicated as draws.
+        int winner = game.is_game_over() ? game.get_winner().value() : GameType::PLAYER_NONE;
+        int result = DRAW;
+
+        if (winner != GameType::PLAYER_NONE) {
+            result = (winner == GameType::PLAYER_MAX) == (max_engine == 0) ? WIN : LOSS;
+        }
+
+        // Updating the match statistics.
+        lock_guard<mutex> lock(statistics_mutex);
+        statistics.results[result]++;
+
+        for (int engine = 0; engine < 2; engine++) {
+            statistics.moves[engine] += game_statistics.moves[engine];
+            statistics.time[engine] += game_statistics.time[engine];
+        }
+
+        double llr = log_likelihood_ratio(statistics, options.elo0, options.elo1);
+        printf("Game %d/%d: %s. Score of engine 1: %lld - %lld - %lld (%.3lf)", game_index + 1, options.games,
+               result == WIN ? "engine 1 wins" : (result == LOSS ? "engine 2 wins" : "draw"), statistics.results[WIN], statistics.results[LOSS],
+               statistics.results[DRAW], statistics.score());
+
+        if (options.sprt) {
+            printf(" LLR = %.3lf", llr);
+
+            if (llr <= log(options.beta / (1.0 - options.alpha)) or llr >= log((1.0 - options.beta) / options.alpha)) {
+                finished = true;
+            }
+        }
+
+        printf("\n");
+        fflush(stdout);
+    }
+}
+
+/* Runs the match and prints the final report. */
+template <class GameType> void run(const Options &options) {
+    vector<string> openings;
+
+    if (options.openings.has_value()) {
+        ifstream file(options.openings.value());
+        string line;
+
+        while (getline(file, line)) {
+            if (!line.empty() and line.back() == '\r') {
+                line.pop_back();
+            }
+
+            if (!line.empty()) {
+                openings.push_back(line);
+            }
+        }
+    }
+
+    Statistics statistics;
+    mutex statistics_mutex;
+    atomic<int> next_game = 0;
+    atomic<bool> finished = false;
+    vector<thread> threads;
+
+    for (int i = 0; i < options.concurrency; i++) {
+        threads.emplace_back(play_games<GameType>, cref(options), cref(openings), ref(next_game), ref(finished), ref(statistics), ref(statistics_mutex));
+    }
+
+    for (thread &t : threads) {
+        t.join();
+    }
+
+    if (statistics.games() == 0) {
+        return;
+    }
+
+    // Elo with a 95% confidence interval.
+    double score = statistics.score();
+    double margin = 1.96 * sqrt(statistics.variance() / statistics.games());
+
+    printf("\nGames: %lld (engine 1: %lld wins, %lld draws, %lld losses)\n", statistics.games(), statistics.results[WIN], statistics.results[DRAW],
+           statistics.results[LOSS]);
+    printf("Score of engine 1: %.2lf%%\n", 100.0 * score);
+    printf("Elo difference: %.1lf +/- %.1lf\n", elo(score), (elo(score + margin) - elo(score - margin)) / 2.0);
+
+    for (int engine = 0; engine < 2; engine++) {
+        printf("Engine %d: %.4lfs per move\n", engine + 1, statistics.moves[engine] > 0 ? statistics.time[engine] / statistics.moves[engine] : 0.0);
+    }
+
+    if (options.sprt) {
+        double llr = log_likelihood_ratio(statistics, options.elo0, options.elo1);
+        double lower = log(options.beta / (1.0 - options.alpha));
+        double upper = log((1.0 - options.beta) / options.alpha);
+
+        printf("SPRT [%.1lf, %.1lf]: LLR = %.3lf (%.3lf, %.3lf) %s\n", options.elo0, options.elo1, llr, lower, upper,
+               llr >= upper ? "H1 accepted" : (llr <= lower ? "H0 accepted" : "inconclusive"));
+    }
+}
+
+void print_usage() {
+    printf("Usage: arena <game> --engine1 <options> --engine2 <options> [--games <n>] [--concurrency <n>]\n");
+    printf("             [--openings <file> | --random-plies <n>] [--max-turns <n>] [--seed <n>] [--sprt <elo0> <elo1> <alpha> <beta>]\n");
+    printf("             [--params <parameter file>]\n");
+    printf("Engine options: engine=<minimax|mcts>,time=<seconds per move>,persistent=<0|1>\n");
+    printf("                Minimax: depth=<plies>,tt=<transposition table megabytes>,lmr=<plies>,extensions=<0|1>,\n");
+    printf("                         quiescence=<0|1>,book=<0|1>\n");
+    printf("                MCTS: playouts=<playouts per move>,threads=<n>\n");
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    bool engines_set[2] = {false, false};
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+
+        if ((arg == "--engine1" or arg == "--engine2") and i + 1 < argc) {
+            int engine = arg == "--engine1" ? 0 : 1;
+            optional<EngineOptions> engine_options = parse_engine(argv[++i]);
+
+            if (!engine_options.has_value()) {
+                print_usage();
+                return 1;
+            }
+
+            options.engines[engine] = engine_options.value();
+            engines_set[engine] = true;
+        } else if (arg == "--games" and i + 1 < argc) {
+            options.games = atoi(argv[++i]);
+        } else if (arg == "--concurrency" and i + 1 < argc) {
+            options.concurrency = max(1, atoi(argv[++i]));
+        } else if (arg == "--openings" and i + 1 < argc) {
+            options.openings = argv[++i];
+        } else if (arg == "--random-plies" and i + 1 < argc) {
+            options.random_plies = atoi(argv[++i]);
+        } else if (arg == "--max-turns" and i + 1 < argc) {
+            options.max_turns = atoi(argv[++i]);
+        } else if (arg == "--seed" and i + 1 < argc) {
+            options.seed = atoi(argv[++i]);
+        } else if (arg == "--params" and i + 1 < argc) {
+            options.parameters = argv[++i];
+        } else if (arg == "--sprt" and i + 4 < argc) {
+            options.sprt = true;
+            options.elo0 = atof(argv[++i]);
+            options.elo1 = atof(argv[++i]);
+            options.alpha = atof(argv[++i]);
+            options.beta = atof(argv[++i]);
+        } else if (options.game_name.empty()) {
+            options.game_name = arg;
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (options.game_name.empty() or !engines_set[0] or !engines_set[1]) {
+        print_usage();
+        return 1;
+    }
+
+    // Both engines evaluate with the same weights and networks, and share the opening books.
+    Parameters::load(options.parameters);
+    BaghChalGame::network.load(NETWORKS_FOLDER_PATH + "BaghChal.nn");
+    KonaneGame::network.load(NETWORKS_FOLDER_PATH + "Konane.nn");
+    Minimax<KonaneGame>::book.load(BOOKS_FOLDER_PATH + "Konane.book");
+    Minimax<MuTorereGame>::book.load(BOOKS_FOLDER_PATH + "MuTorere.book");
+    Minimax<BaghChalGame>::book.load(BOOKS_FOLDER_PATH + "BaghChal.book");
+    Minimax<TicTacToeGame>::book.load(BOOKS_FOLDER_PATH + "TicTacToe.book");
+    Minimax<ConnectFourGame>::book.load(BOOKS_FOLDER_PATH + "ConnectFour.book");
+
+    if (options.game_name == "Konane") {
+        run<KonaneGame>(options);
+    } else if (options.game_name == "MuTorere") {
+        run<MuTorereGame>(options);
+    } else if (options.game_name == "BaghChal") {
+        run<BaghChalGame>(options);
+    } else if (options.game_name == "TicTacToe") {
+        run<TicTacToeGame>(options);
+    } else if (options.game_name == "ConnectFour") {
+        run<ConnectFourGame>(options);
+    } else {
+        printf("%s has not been implemented.\n", options.game_name.c_str());
+        return 1;
+    }
+
+    return 0;
+}
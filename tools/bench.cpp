@@ -0,0 +1,232 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/* Common. */
+#include <Game.hpp>
+#include <Minimax.hpp>
+#include <Parameters.hpp>
+#include <SearchStatistics.hpp>
+
+/* Games. */
+#include <BaghChalGame.hpp>
+#include <ConnectFourGame.hpp>
+#include <KonaneGame.hpp>
+#include <MuTorereGame.hpp>
+#include <TicTacToeGame.hpp>
+
+using namespace std;
+
+/* Constants. */
+const string POSITIONS_FOLDER_PATH = "data/positions/";
+const string DEFAULT_JSON_PATH = "bench.json";
+const string PARAMETERS_PATH = "data/params.txt";
+const string NETWORKS_FOLDER_PATH = "data/";
+constexpr unsigned long long FNV_OFFSET_BASIS = 14695981039346656037ull;
+constexpr unsigned long long FNV_PRIME = 1099511628211ull;
+
+/* Result of searching a single position. */
+class PositionResult {
+  public:
+    string state, move;
+    double score;
+    int depth;
+    long long nodes, transposition_table_probes, transposition_table_hits;
+    double time;
+    SearchStatistics statistics;
+};
+
+/* Result of searching all positions of a game. */
+class GameResult {
+  public:
+    string game_name;
+    int depth;
+    vector<PositionResult> positions;
+    long long nodes = 0, transposition_table_probes = 0, transposition_table_hits = 0;
+    double time = 0.0;
+    unsigned long long signature = FNV_OFFSET_BASIS;
+};
+
+/* Mixes a string into a FNV-1a hash. */
+unsigned long long fnv1a(unsigned long long hash, const string &str) {
+    for (unsigned char c : str) {
+        hash = (hash ^ c) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/* Returns nodes per second. */
+double nodes_per_second(long long nodes, double time) {
+    return time > 0.0 ? nodes / time : 0.0;
+}
+
+/* Returns the transposition table hit rate. */
+double hit_rate(long long hits, long long probes) {
+    return probes > 0 ? static_cast<double>(hits) / probes : 0.0;
+}
+
+/* Returns the string escaped for JSON. */
+string escape(const string &str) {
+    string ans;
+
+    for (char c : str) {
+        if (c == '"' or c == '\\') {
+            ans += '\\';
+        }
+
+        ans += c;
+    }
+
+    return ans;
+}
+
+/* Searches every position of the game to a fixed depth. Every search starts from an empty Minimax, so results don't depend on order. */
+template <class GameType, class StateType = typename GameType::state_type> GameResult benchmark(const string &game_name, int depth) {
+    typename Minimax<GameType>::Limits limits;
+    limits.depth = depth;
+
+    Minimax<GameType> ai;
+    GameResult result;
+    result.game_name = game_name;
+    result.depth = depth;
+
+    ifstream file(POSITIONS_FOLDER_PATH + game_name + ".txt");
+    string serialized_state;
+
+    while (getline(file, serialized_state)) {
+        if (!serialized_state.empty() and serialized_state.back() == '\r') {
+            serialized_state.pop_back();
+        }
+
+        if (serialized_state.empty()) {
+            continue;
+        }
+
+        GameType game(StateType::deserialize(serialized_state));
+        ai.clear();
+
+        chrono::time_point<chrono::high_resolution_clock> t_start = chrono::high_resolution_clock::now();
+        auto [ans, reached_depth, statistics] = ai.get_move(game, limits);
+        chrono::duration<double> t = chrono::high_resolution_clock::now() - t_start;
+
+        PositionResult position;
+        position.state = serialized_state;
+        position.move = string(ans.move);
+        position.score = ans.evaluation();
+        position.depth = reached_depth;
+        position.nodes = statistics.nodes;
+        position.transposition_table_probes = statistics.transposition_table_probes;
+        position.transposition_table_hits = statistics.transposition_table_hits;
+        position.time = t.count();
+        position.statistics = statistics;
+
+        result.nodes += position.nodes;
+        result.transposition_table_probes += position.transposition_table_probes;
+        result.transposition_table_hits += position.transposition_table_hits;
+        result.time += position.time;
+        result.signature = fnv1a(result.signature, to_string(position.nodes) + " " + position.move + "\n");
+        result.positions.push_back(position);
+    }
+
+    return result;
+}
+
+/* Prints the results as a table. */
+void print_table(const vector<GameResult> &results, long long nodes, double time, unsigned long long signature) {
+    printf("%-12s %9s %5s %12s %9s %12s %7s %18s\n", "Game", "Positions", "Depth", "Nodes", "Time", "Nodes/s", "TT hit", "Signature");
+
+    for (const GameResult &result : results) {
+        printf("%-12s %9d %5d %12lld %8.3lfs %12.0lf %6.1lf%% %18llx\n", result.game_name.c_str(), static_cast<int>(result.positions.size()), result.depth,
+               result.nodes, result.time, nodes_per_second(result.nodes, result.time),
+               100.0 * hit_rate(result.transposition_table_hits, result.transposition_table_probes), result.signature);
+    }
+
+    printf("%-12s %9s %5s %12lld %8.3lfs %12.0lf %7s %18llx\n", "Total", "", "", nodes, time, nodes_per_second(nodes, time), "", signature);
+}
+
+/* Writes the results as JSON. */
+void write_json(const string &path, const vector<GameResult> &results, long long nodes, double time, unsigned long long signature) {
+    FILE *file = fopen(path.c_str(), "w");
+
+    if (file == nullptr) {
+        fprintf(stderr, "Could not open %s\n", path.c_str());
+        return;
+    }
+
+    fprintf(file, "{\n  \"games\": [\n");
+
+    for (int i = 0; i < results.size(); i++) {
+        const GameResult &result = results[i];
+
+        fprintf(file, "    {\n");
+        fprintf(file, "      \"game\": \"%s\",\n", result.game_name.c_str());
+        fprintf(file, "      \"depth\": %d,\n", result.depth);
+        fprintf(file, "      \"nodes\": %lld,\n", result.nodes);
+        fprintf(file, "      \"time\": %.6lf,\n", result.time);
+        fprintf(file, "      \"nodes_per_second\": %.0lf,\n", nodes_per_second(result.nodes, result.time));
+        fprintf(file, "      \"tt_probes\": %lld,\n", result.transposition_table_probes);
+        fprintf(file, "      \"tt_hits\": %lld,\n", result.transposition_table_hits);
+        fprintf(file, "      \"tt_hit_rate\": %.6lf,\n", hit_rate(result.transposition_table_hits, result.transposition_table_probes));
+        fprintf(file, "      \"signature\": \"%016llx\",\n", result.signature);
+        fprintf(file, "      \"positions\": [\n");
+
+        for (int j = 0; j < result.positions.size(); j++) {
+            const PositionResult &position = result.positions[j];
+
+            fprintf(file,
+                    "        {\"state\": \"%s\", \"move\": \"%s\", \"score\": %.6lf, \"depth\": %d, \"nodes\": %lld, \"time\": %.6lf, \"nodes_per_second\": %.0lf, "
+                    "\"tt_probes\": %lld, \"tt_hits\": %lld, \"statistics\": %s}%s\n",
+                    escape(position.state).c_str(), escape(position.move).c_str(), position.score, position.depth, position.nodes, position.time,
+                    nodes_per_second(position.nodes, position.time), position.transposition_table_probes, position.transposition_table_hits,
+                    position.statistics.to_json().c_str(), j + 1 < result.positions.size() ? "," : "");
+        }
+
+        fprintf(file, "      ]\n");
+        fprintf(file, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+
+    fprintf(file, "  ],\n");
+    fprintf(file, "  \"nodes\": %lld,\n", nodes);
+    fprintf(file, "  \"time\": %.6lf,\n", time);
+    fprintf(file, "  \"nodes_per_second\": %.0lf,\n", nodes_per_second(nodes, time));
+    fprintf(file, "  \"signature\": \"%016llx\"\n", signature);
+    fprintf(file, "}\n");
+    fclose(file);
+}
+
+/* Usage: bench [JSON output path] */
+int main(int argc, char *argv[]) {
+    string json_path = argc > 1 ? argv[1] : DEFAULT_JSON_PATH;
+    vector<GameResult> results;
+
+    // Evaluating with the same weights as the game.
+    Parameters::load(PARAMETERS_PATH);
+    BaghChalGame::network.load(NETWORKS_FOLDER_PATH + "BaghChal.nn");
+    KonaneGame::network.load(NETWORKS_FOLDER_PATH + "Konane.nn");
+
+    // Fixed depths, chosen so that every game takes a similar amount of time.
+    results.push_back(benchmark<KonaneGame>("Konane", 13));
+    results.push_back(benchmark<MuTorereGame>("MuTorere", 50));
+    results.push_back(benchmark<BaghChalGame>("BaghChal", 9));
+    results.push_back(benchmark<TicTacToeGame>("TicTacToe", 9));
+    results.push_back(benchmark<ConnectFourGame>("ConnectFour", 11));
+
+    // Totals.
+    long long nodes = 0;
+    double time = 0.0;
+    unsigned long long signature = FNV_OFFSET_BASIS;
+
+    for (const GameResult &result : results) {
+        nodes += result.nodes;
+        time += result.time;
+        signature = fnv1a(signature, result.game_name + " " + to_string(result.signature) + "\n");
+    }
+
+    print_table(results, nodes, time, signature);
+    write_json(json_path, results, nodes, time, signature);
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+/* Common. */
+#include <Game.hpp>
+#include <Minimax.hpp>
+#include <OpeningBook.hpp>
+#include <Parameters.hpp>
+
+/* Games. */
+#include <BaghChalGame.hpp>
+#include <ConnectFourGame.hpp>
+#include <KonaneGame.hpp>
+#include <MuTorereGame.hpp>
+#include <TicTacToeGame.hpp>
+
+using namespace std;
+
+/* Constants. */
+const string BOOKS_FOLDER_PATH = "data/";
+const string PARAMETERS_PATH = "data/params.txt";
+const string NETWORKS_FOLDER_PATH = "data/";
+constexpr int DEFAULT_PLIES = 2;
+constexpr double DEFAULT_TIME = 2.0;
+
+/* Command line options. */
+class Options {
+  public:
+    string game_name;
+    int plies = DEFAULT_PLIES;
+    optional<int> depth = nullopt;
+    double time = DEFAULT_TIME;
+    int threads = max(1u, thread::hardware_concurrency());
+    optional<size_t> tt = nullopt;
+    string output;
+};
+
+/* Collects the states reached in the first plies of the game, without repetitions or finished games. */
+template <class GameType, class StateType = typename GameType::state_type>
+void collect_states(GameType &game, int plies, unordered_set<uint64_t> &keys, vector<StateType> &states) {
+    if (game.is_game_over() or !keys.insert(OpeningBook<GameType>::get_key(game.get_state())).second) {
+        return;
+    }
+
+    states.push_back(game.get_state());
+
+    if (plies == 0) {
+        return;
+    }
+
+    for (const auto &move : game.get_moves()) {
+        game.make_move(move);
+        collect_states(game, plies - 1, keys, states);
+        game.rollback();
+    }
+}
+
+/* Searches every state of the first plies of the game on a pool of threads and saves the best moves as an opening book. */
+template <class GameType, class StateType = typename GameType::state_type> void build_book(const Options &options) {
+    typename Minimax<GameType>::Settings settings;
+    typename Minimax<GameType>::Limits limits;
+    settings.opening_book = false;
+
+    if (options.depth.has_value()) {
+        limits.depth = options.depth;
+    } else {
+        limits.timeout = chrono::duration<long double>(options.time);
+    }
+
+    if (options.tt.has_value()) {
+        settings.transposition_table_megabytes = options.tt.value();
+    }
+
+    GameType start;
+    unordered_set<uint64_t> keys;
+    vector<StateType> states;
+    collect_states(start, options.plies, keys, states);
+    printf("Searching %d states of the first %d plies on %d threads\n", static_cast<int>(states.size()), options.plies, options.threads);
+
+    vector<typename OpeningBook<GameType>::Entry> entries(states.size());
+    atomic<int> next_state = 0, searched = 0;
+    mutex output_mutex;
+
+    auto worker = [&]() {
+        Minimax<GameType> ai(settings);
+
+        for (int i = next_state++; i < states.size(); i = next_state++) {
+            // Every state starts from an empty Minimax, so entries don't depend on which thread searched them.
+            GameType game(states[i]);
+            ai.clear();
+
+            auto [ans, reached_depth, statistics] = ai.get_move(game, limits);
+            entries[i] = Minimax<GameType>::make_book_entry(game, ans, reached_depth);
+
+            lock_guard<mutex> lock(output_mutex);
+            printf("\r%d/%d", ++searched, static_cast<int>(states.size()));
+            fflush(stdout);
+        }
+    };
+
+    chrono::time_point<chrono::high_resolution_clock> t_start = chrono::high_resolution_clock::now();
+    vector<thread> threads;
+
+    for (int i = 0; i < options.threads; i++) {
+        threads.emplace_back(worker);
+    }
+
+    for (thread &t : threads) {
+        t.join();
+    }
+
+    chrono::duration<double> t = chrono::high_resolution_clock::now() - t_start;
+    OpeningBook<GameType> book;
+    book.set_entries(entries);
+
+    if (!book.save(options.output)) {
+        fprintf(stderr, "\nCould not write %s\n", options.output.c_str());
+        return;
+    }
+
+    printf("\nSaved %d entries to %s in %.3lfs\n", static_cast<int>(book.size()), options.output.c_str(), t.count());
+}
+
+/* Usage: book <game> [--plies <n>] [--depth <plies> | --time <seconds>] [--threads <n>] [--tt <megabytes>] [--output <file>] */
+int main(int argc, char *argv[]) {
+    Options options;
+    bool valid = argc > 1;
+
+    for (int i = 1; i < argc and valid; i++) {
+        string arg = argv[i];
+
+        if (arg == "--plies" and i + 1 < argc) {
+            options.plies = max(0, atoi(argv[++i]));
+        } else if (arg == "--depth" and i + 1 < argc) {
+            options.depth = max(1, atoi(argv[++i]));
+        } else if (arg == "--time" and i + 1 < argc) {
+            options.time = atof(argv[++i]);
+        } else if (arg == "--threads" and i + 1 < argc) {
+            options.threads = max(1, atoi(argv[++i]));
+        } else if (arg == "--tt" and i + 1 < argc) {
+            options.tt = max(1ll, atoll(argv[++i]));
+        } else if (arg == "--output" and i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (arg.rfind("--", 0) == 0 or !options.game_name.empty()) {
+            valid = false;
+        } else {
+            options.game_name = arg;
+        }
+    }
+
+    if (!valid) {
+        printf("Usage: book <game> [--plies <n>] [--depth <plies> | --time <seconds>] [--threads <n>] [--tt <megabytes>] [--output <file>]\n");
+        return 1;
+    }
+
+    if (options.output.empty()) {
+        options.output = BOOKS_FOLDER_PATH + options.game_name + ".book";
+    }
+
+    // Searching with the same weights as the game.
+    Parameters::load(PARAMETERS_PATH);
+    BaghChalGame::network.load(NETWORKS_FOLDER_PATH + "BaghChal.nn");
+    KonaneGame::network.load(NETWORKS_FOLDER_PATH + "Konane.nn");
+
+    if (options.game_name == "Konane") {
+        build_book<KonaneGame>(options);
+    } else if (options.game_name == "MuTorere") {
+        build_book<MuTorereGame>(options);
+    } else if (options.game_name == "BaghChal") {
+        build_book<BaghChalGame>(options);
+    } else if (options.game_name == "TicTacToe") {
+        build_book<TicTacToeGame>(options);
+    } else if (options.game_name == "ConnectFour") {
+        build_book<ConnectFourGame>(options);
+    } else {
+        printf("Unknown game %s\n", options.game_name.c_str());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+/* Common. */
+#include <Game.hpp>
+#include <Perft.hpp>
+
+/* Games. */
+#include <BaghChalGame.hpp>
+#include <ConnectFourGame.hpp>
+#include <KonaneGame.hpp>
+#include <MuTorereGame.hpp>
+#include <TicTacToeGame.hpp>
+
+using namespace std;
+
+/* Constants. */
+const string REFERENCE_TABLE_PATH = "data/perft.txt";
+
+/* Command line options. */
+class Options {
+  public:
+    string game_name;
+    int depth = 0;
+    bool divide = false;
+    bool verify = false;
+    optional<string> state = nullopt;
+    int threads = 1;
+    bool bulk = true;
+};
+
+/* Returns the game, from its initial state or from the given serialized state. */
+template <class GameType, class StateType = typename GameType::state_type> GameType create_game(const optional<string> &state) {
+    if (state.has_value()) {
+        return GameType(StateType::deserialize(state.value()));
+    }
+
+    return GameType();
+}
+
+/* Prints the number of leaves for every depth up to options.depth, or per root move in divide mode. */
+template <class GameType, class MoveType = typename GameType::move_type> void run(const Options &options) {
+    typename Perft<GameType>::Settings settings;
+    settings.bulk = options.bulk;
+    settings.threads = options.threads;
+
+    Perft<GameType> perft(settings);
+    GameType game = create_game<GameType>(options.state);
+
+    if (options.divide) {
+        long long leaves = 0;
+
+        for (const auto &[move, count] : perft.divide(game, options.depth)) {
+            printf("%-24s %lld\n", string(move).c_str(), count);
+            leaves += count;
+        }
+
+        printf("\nMoves: %d\nLeaves: %lld\n", static_cast<int>(game.get_moves().size()), leaves);
+        return;
+    }
+
+    printf("%5s %16s %10s %14s\n", "Depth", "Leaves", "Time", "Leaves/s");
+
+    for (int depth = 1; depth <= options.depth; depth++) {
+        chrono::time_point<chrono::high_resolution_clock> t_start = chrono::high_resolution_clock::now();
+        long long leaves = perft.run(game, depth);
+        chrono::duration<double> t = chrono::high_resolution_clock::now() - t_start;
+
+        printf("%5d %16lld %9.3lfs %14.0lf\n", depth, leaves, t.count(), t.count() > 0.0 ? leaves / t.count() : 0.0);
+        fflush(stdout);
+    }
+}
+
+/* Returns the number of leaves at the given depth from the initial state. */
+template <class GameType> long long count_leaves(int depth, int threads) {
+    typename Perft<GameType>::Settings settings;
+    settings.threads = threads;
+    return Perft<GameType>(settings).run(GameType(), depth);
+}
+
+/* Checks every entry of the reference table. Returns false if any count differs. */
+bool verify(int threads) {
+    ifstream file(REFERENCE_TABLE_PATH);
+    string game_name;
+    int depth;
+    long long expected;
+    bool ok = true;
+
+    while (file >> game_name >> depth >> expected) {
+        optional<long long> leaves = nullopt;
+
+        if (game_name == "Konane") {
+            leaves = count_leaves<KonaneGame>(depth, threads);
+        } else if (game_name == "MuTorere") {
+            leaves = count_leaves<MuTorereGame>(depth, threads);
+        } else if (game_name == "BaghChal") {
+            leaves = count_leaves<BaghChalGame>(depth, threads);
+        } else if (game_name == "TicTacToe") {
+            leaves = count_leaves<TicTacToeGame>(depth, threads);
+        } else if (game_name == "ConnectFour") {
+            leaves = count_leaves<ConnectFourGame>(depth, threads);
+        }
+
+        if (leaves == expected) {
+            printf("%-12s %3d %16lld OK\n", game_name.c_str(), depth, expected);
+        } else {
+            printf("%-12s %3d %16lld FAILED (got %lld)\n", game_name.c_str(), depth, expected, leaves.value_or(-1));
+            ok = false;
+        }
+
+        fflush(stdout);
+    }
+
+    return ok;
+}
+
+/* Usage: perft <game> <depth> [--divide] [--state <serialized state>] [--threads <n>] [--no-bulk]
+          perft --verify [--threads <n>] */
+int main(int argc, char *argv[]) {
+    Options options;
+    vector<string> positional;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+
+        if (arg == "--divide") {
+            options.divide = true;
+        } else if (arg == "--verify") {
+            options.verify = true;
+        } else if (arg == "--no-bulk") {
+            options.bulk = false;
+        } else if (arg == "--state" and i + 1 < argc) {
+            options.state = argv[++i];
+        } else if (arg == "--threads" and i + 1 < argc) {
+            options.threads = max(1, atoi(argv[++i]));
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (options.verify) {
+        return verify(options.threads) ? 0 : 1;
+    }
+
+    if (positional.size() != 2) {
+        printf("Usage: perft <game> <depth> [--divide] [--state <serialized state>] [--threads <n>] [--no-bulk]\n");
+        printf("       perft --verify [--threads <n>]\n");
+        return 1;
+    }
+
+    options.game_name = positional[0];
+    options.depth = atoi(positional[1].c_str());
+
+    if (options.depth < 1) {
+        printf("The depth has to be at least 1\n");
+        return 1;
+    }
+
+    if (options.game_name == "Konane") {
+        run<KonaneGame>(options);
+    } else if (options.game_name == "MuTorere") {
+        run<MuTorereGame>(options);
+    } else if (options.game_name == "BaghChal") {
+        run<BaghChalGame>(options);
+    } else if (options.game_name == "TicTacToe") {
+        run<TicTacToeGame>(options);
+    } else if (options.game_name == "ConnectFour") {
+        run<ConnectFourGame>(options);
+    } else if (options.game_name == "Konane8x8") { // Other board sizes, to compare how the games scale.
+        run<BasicKonaneGame<8, 8>>(options);
+    } else if (options.game_name == "ConnectFour7x8") {
+        run<BasicConnectFourGame<7, 8>>(options);
+    } else if (options.game_name == "TicTacToe4x4x4") {
+        run<BasicTicTacToeGame<4, 4, 4>>(options);
+    } else if (options.game_name == "TicTacToe5x5x4") {
+        run<BasicTicTacToeGame<5, 5, 4>>(options);
+    } else {
+        printf("%s has not been implemented.\n", options.game_name.c_str());
+        return 1;
+    }
+
+    return 0;
+}
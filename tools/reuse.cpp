@@ -0,0 +1,72 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/* Common. */
+#include <Game.hpp>
+#include <Minimax.hpp>
+
+/* Games. */
+#include <BaghChalGame.hpp>
+#include <ConnectFourGame.hpp>
+#include <KonaneGame.hpp>
+#include <MuTorereGame.hpp>
+#include <TicTacToeGame.hpp>
+
+using namespace std;
+
+/* Constants. */
+constexpr chrono::duration<long double> DEFAULT_TIMEOUT = 0.1s;
+constexpr int MAX_TURNS = 100; // Games with cycles may never end.
+
+/* Plays a CPU vs CPU game with a persistent Minimax and compares it against a fresh search of every position: the depth that iterative deepening
+   completes within the timeout, and the nodes that searches to a fixed depth take, which is what reuse saves. */
+template <class GameType> void benchmark(const string &game_name, chrono::duration<long double> timeout, int fixed_depth) {
+    typename Minimax<GameType>::Settings persistent_settings, fresh_settings;
+    persistent_settings.opening_book = fresh_settings.opening_book = false;
+    fresh_settings.persistent = false;
+
+    typename Minimax<GameType>::Limits fixed_limits;
+    fixed_limits.depth = fixed_depth;
+
+    Minimax<GameType> persistent_ai(persistent_settings), fresh_ai(fresh_settings);
+    Minimax<GameType> fixed_persistent_ai(persistent_settings), fixed_fresh_ai(fresh_settings);
+    long long persistent_depth = 0, fresh_depth = 0, persistent_nodes = 0, fresh_nodes = 0;
+    int moves = 0;
+    GameType game;
+
+    while (!game.is_game_over() and game.get_turn() < MAX_TURNS) {
+        fresh_depth += get<1>(fresh_ai.get_move(game, timeout));
+        fresh_nodes += get<2>(fixed_fresh_ai.get_move(game, fixed_limits)).nodes;
+        persistent_nodes += get<2>(fixed_persistent_ai.get_move(game, fixed_limits)).nodes;
+
+        auto [ans, depth, statistics] = persistent_ai.get_move(game, timeout);
+        persistent_depth += depth;
+        moves++;
+
+        game.make_move(ans.move);
+    }
+
+    printf("%-12s %6d %10.2lf %10.2lf %+8.2lf %6d %12lld %12lld %7.1lf%%\n", game_name.c_str(), moves, static_cast<double>(fresh_depth) / moves,
+           static_cast<double>(persistent_depth) / moves, static_cast<double>(persistent_depth - fresh_depth) / moves, fixed_depth, fresh_nodes / moves,
+           persistent_nodes / moves, fresh_nodes > 0 ? 100.0 * (fresh_nodes - persistent_nodes) / fresh_nodes : 0.0);
+    fflush(stdout);
+}
+
+/* Usage: reuse [timeout in seconds] */
+int main(int argc, char *argv[]) {
+    chrono::duration<long double> timeout = argc > 1 ? chrono::duration<long double>(atof(argv[1])) : DEFAULT_TIMEOUT;
+
+    printf("Average depth completed per move (timeout = %.3Lfs) and average nodes per move searching to a fixed depth\n", timeout.count());
+    printf("%-12s %6s %10s %10s %8s %6s %12s %12s %8s\n", "Game", "Moves", "Fresh", "Persistent", "Gain", "Depth", "Fresh", "Persistent", "Saved");
+
+    benchmark<KonaneGame>("Konane", timeout, 6);
+    benchmark<MuTorereGame>("MuTorere", timeout, 16);
+    benchmark<BaghChalGame>("BaghChal", timeout, 6);
+    benchmark<TicTacToeGame>("TicTacToe", timeout, 9);
+    benchmark<ConnectFourGame>("ConnectFour", timeout, 8);
+
+    return 0;
+}
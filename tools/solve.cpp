@@ -0,0 +1,162 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/* Common. */
+#include <Game.hpp>
+#include <ProofNumber.hpp>
+
+/* Games. */
+#include <BaghChalGame.hpp>
+#include <ConnectFourGame.hpp>
+#include <KonaneGame.hpp>
+#include <MuTorereGame.hpp>
+#include <TicTacToeGame.hpp>
+
+using namespace std;
+
+/* Constants. */
+const string POSITIONS_FOLDER_PATH = "data/positions/";
+constexpr double DEFAULT_TIME = 10.0;
+
+/* Command line options. */
+class Options {
+  public:
+    string game_name;
+    string positions_path;
+    double time = DEFAULT_TIME;
+    optional<long long> nodes = nullopt;
+    optional<size_t> tt = nullopt;
+};
+
+/* Returns the verdict as text. */
+template <class GameType> string get_verdict(const optional<int> &winner) {
+    if (!winner.has_value()) {
+        return "unknown";
+    }
+
+    if (winner.value() == GameType::PLAYER_MAX) {
+        return "max wins";
+    }
+
+    if (winner.value() == GameType::PLAYER_MIN) {
+        return "min wins";
+    }
+
+    return "draw";
+}
+
+/* Solves every position of the file with proof-number search, printing one line per position as soon as it is solved. */
+template <class GameType, class StateType = typename GameType::state_type, class MoveType = typename GameType::move_type>
+void solve_positions(const Options &options) {
+    typename ProofNumber<GameType>::Settings settings;
+    typename ProofNumber<GameType>::Limits limits;
+    limits.timeout = chrono::duration<long double>(options.time);
+    limits.nodes = options.nodes;
+
+    if (options.tt.has_value()) {
+        settings.transposition_table_capacity = options.tt.value();
+    }
+
+    ifstream file(options.positions_path);
+    string serialized_state;
+    int positions = 0, solved = 0;
+    long long total_nodes = 0;
+    double total_time = 0.0;
+
+    if (!file) {
+        fprintf(stderr, "Could not open %s\n", options.positions_path.c_str());
+        return;
+    }
+
+    printf("%-4s %-9s %12s %12s %9s  %s\n", "#", "Verdict", "Nodes", "Proof tree", "Time", "Principal variation");
+
+    while (getline(file, serialized_state)) {
+        if (!serialized_state.empty() and serialized_state.back() == '\r') {
+            serialized_state.pop_back();
+        }
+
+        if (serialized_state.empty()) {
+            continue;
+        }
+
+        // Every position starts from an empty transposition table, so results don't depend on order.
+        ProofNumber<GameType> solver(settings);
+        GameType game(StateType::deserialize(serialized_state));
+
+        chrono::time_point<chrono::high_resolution_clock> t_start = chrono::high_resolution_clock::now();
+        typename ProofNumber<GameType>::Result result = solver.solve(game, limits);
+        chrono::duration<double> t = chrono::high_resolution_clock::now() - t_start;
+
+        string principal_variation;
+
+        for (const MoveType &move : result.principal_variation) {
+            principal_variation += (principal_variation.empty() ? "" : " ") + string(move);
+        }
+
+        printf("%-4d %-9s %12lld %12lld %8.3lfs  %s\n", ++positions, get_verdict<GameType>(result.winner).c_str(), result.nodes, result.proof_tree_size,
+               t.count(), principal_variation.c_str());
+        fflush(stdout);
+
+        solved += result.winner.has_value();
+        total_nodes += result.nodes;
+        total_time += t.count();
+    }
+
+    printf("Solved %d of %d positions (%lld nodes, %.3lfs)\n", solved, positions, total_nodes, total_time);
+}
+
+/* Usage: solve <game> [<positions file>] [--time <seconds>] [--nodes <n>] [--tt <entries>] */
+int main(int argc, char *argv[]) {
+    Options options;
+    bool valid = argc > 1;
+
+    for (int i = 1; i < argc and valid; i++) {
+        string arg = argv[i];
+
+        if (arg == "--time" and i + 1 < argc) {
+            options.time = atof(argv[++i]);
+        } else if (arg == "--nodes" and i + 1 < argc) {
+            options.nodes = atoll(argv[++i]);
+        } else if (arg == "--tt" and i + 1 < argc) {
+            options.tt = max(1ll, atoll(argv[++i]));
+        } else if (arg.rfind("--", 0) == 0) {
+            valid = false;
+        } else if (options.game_name.empty()) {
+            options.game_name = arg;
+        } else if (options.positions_path.empty()) {
+            options.positions_path = arg;
+        } else {
+            valid = false;
+        }
+    }
+
+    if (!valid) {
+        printf("Usage: solve <game> [<positions file>] [--time <seconds>] [--nodes <n>] [--tt <entries>]\n");
+        return 1;
+    }
+
+    if (options.positions_path.empty()) {
+        options.positions_path = POSITIONS_FOLDER_PATH + options.game_name + ".txt";
+    }
+
+    if (options.game_name == "Konane") {
+        solve_positions<KonaneGame>(options);
+    } else if (options.game_name == "MuTorere") {
+        solve_positions<MuTorereGame>(options);
+    } else if (options.game_name == "BaghChal") {
+        solve_positions<BaghChalGame>(options);
+    } else if (options.game_name == "TicTacToe") {
+        solve_positions<TicTacToeGame>(options);
+    } else if (options.game_name == "ConnectFour") {
+        solve_positions<ConnectFourGame>(options);
+    } else {
+        printf("Unknown game %s\n", options.game_name.c_str());
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
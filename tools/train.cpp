@@ -0,0 +1,427 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Common. */
+#include <Game.hpp>
+#include <Network.hpp>
+#include <Parameters.hpp>
+#include <SelfPlay.hpp>
+
+/* Games. */
+#include <BaghChalGame.hpp>
+#include <KonaneGame.hpp>
+
+using namespace std;
+
+/* Constants. */
+const string PARAMETERS_PATH = "data/params.txt";
+const string NETWORKS_FOLDER_PATH = "data/";
+constexpr int VALIDATION_INTERVAL = 10; // One in VALIDATION_INTERVAL positions is kept out of training.
+constexpr double ADAM_BETA1 = 0.9, ADAM_BETA2 = 0.999, ADAM_EPSILON = 1e-8;
+
+/* Command line options. */
+class Options {
+  public:
+    string game_name;
+    int games = 1000;
+    int depth = 4;
+    int random_plies = 8;
+    int multi_pv = 1;
+    int max_turns = 200;
+    int threads = max(1u, thread::hardware_concurrency());
+    int epochs = 30;
+    int batch_size = 256;
+    double learning_rate = 0.001;
+    optional<string> positions = nullopt;
+    optional<string> save_positions = nullopt;
+    optional<string> output = nullopt;
+    unsigned int seed = 0;
+};
+
+/* Active network inputs of a position with the result of its game, between -1 and 1. */
+class Sample {
+  public:
+    vector<int> inputs;
+    float result;
+};
+
+/* Floating point copy of the quantized network, with the same layers and clipped activations. Parameters are stored in a single array. */
+template <int INPUTS> class FloatNetwork {
+  public:
+    using QuantizedNetwork = Network<INPUTS>;
+
+    static constexpr int H1 = QuantizedNetwork::HIDDEN1;
+    static constexpr int H2 = QuantizedNetwork::HIDDEN2;
+
+    /* Offsets of every layer in the parameter array. */
+    static constexpr int INPUT_WEIGHTS = 0;
+    static constexpr int INPUT_BIASES = INPUT_WEIGHTS + INPUTS * H1;
+    static constexpr int HIDDEN_WEIGHTS = INPUT_BIASES + H1;
+    static constexpr int HIDDEN_BIASES = HIDDEN_WEIGHTS + H2 * H1;
+    static constexpr int OUTPUT_WEIGHTS = HIDDEN_BIASES + H2;
+    static constexpr int OUTPUT_BIAS = OUTPUT_WEIGHTS + H2;
+    static constexpr int SIZE = OUTPUT_BIAS + 1;
+
+    /* Largest weight after the first layer that fits in int8. */
+    static constexpr double MAX_WEIGHT = 127.0 / QuantizedNetwork::WEIGHT_SCALE;
+
+    vector<double> parameters;
+
+    explicit FloatNetwork(unsigned int seed) : parameters(SIZE, 0.0) {
+        mt19937 rng(seed);
+        uniform_real_distribution<double> input_weight(-0.2, 0.2), hidden_weight(-1.0 / sqrt(H1), 1.0 / sqrt(H1)),
+            output_weight(-1.0 / sqrt(H2), 1.0 / sqrt(H2));
+
+        for (int i = 0; i < INPUTS * H1; i++) {
+            parameters[INPUT_WEIGHTS + i] = input_weight(rng);
+        }
+
+        for (int i = 0; i < H2 * H1; i++) {
+            parameters[HIDDEN_WEIGHTS + i] = hidden_weight(rng);
+        }
+
+        for (int j = 0; j < H2; j++) {
+            parameters[OUTPUT_WEIGHTS + j] = output_weight(rng);
+        }
+
+        // Activations start in the middle of their clipped range.
+        fill(parameters.begin() + INPUT_BIASES, parameters.begin() + INPUT_BIASES + H1, 0.5);
+        fill(parameters.begin() + HIDDEN_BIASES, parameters.begin() + HIDDEN_BIASES + H2, 0.5);
+    }
+
+    /* Returns the squared error of the sample, and adds its gradient to the given array if any. */
+    double get_loss(const Sample &sample, vector<double> *gradient) const {
+        const double *p = parameters.data();
+        double z1[H1], a1[H1], z2[H2], a2[H2];
+
+        for (int k = 0; k < H1; k++) {
+            z1[k] = p[INPUT_BIASES + k];
+        }
+
+        for (int input : sample.inputs) {
+            for (int k = 0; k < H1; k++) {
+                z1[k] += p[INPUT_WEIGHTS + input * H1 + k];
+            }
+        }
+
+        for (int k = 0; k < H1; k++) {
+            a1[k] = clamp(z1[k], 0.0, 1.0);
+        }
+
+        double z3 = p[OUTPUT_BIAS];
+
+        for (int j = 0; j < H2; j++) {
+            z2[j] = p[HIDDEN_BIASES + j];
+
+            for (int k = 0; k < H1; k++) {
+                z2[j] += p[HIDDEN_WEIGHTS + j * H1 + k] * a1[k];
+            }
+
+            a2[j] = clamp(z2[j], 0.0, 1.0);
+            z3 += p[OUTPUT_WEIGHTS + j] * a2[j];
+        }
+
+        double y = tanh(z3);
+
+        if (gradient != nullptr) {
+            double *g = gradient->data();
+            double dz3 = 2.0 * (y - sample.result) * (1.0 - y * y);
+            double dz1[H1] = {};
+
+            g[OUTPUT_BIAS] += dz3;
+
+            for (int j = 0; j < H2; j++) {
+                g[OUTPUT_WEIGHTS + j] += dz3 * a2[j];
+                double dz2 = 0.0 < z2[j] and z2[j] < 1.0 ? dz3 * p[OUTPUT_WEIGHTS + j] : 0.0;
+
+                if (dz2 != 0.0) {
+                    g[HIDDEN_BIASES + j] += dz2;
+
+                    for (int k = 0; k < H1; k++) {
+                        g[HIDDEN_WEIGHTS + j * H1 + k] += dz2 * a1[k];
+                        dz1[k] += dz2 * p[HIDDEN_WEIGHTS + j * H1 + k];
+                    }
+                }
+            }
+
+            for (int k = 0; k < H1; k++) {
+                if (z1[k] <= 0.0 or z1[k] >= 1.0) {
+                    dz1[k] = 0.0;
+                }
+
+                g[INPUT_BIASES + k] += dz1[k];
+            }
+
+            for (int input : sample.inputs) {
+                for (int k = 0; k < H1; k++) {
+                    g[INPUT_WEIGHTS + input * H1 + k] += dz1[k];
+                }
+            }
+        }
+
+        return (y - sample.result) * (y - sample.result);
+    }
+
+    /* Keeps the weights after the first layer inside the quantized range. */
+    void clip() {
+        for (int i = HIDDEN_WEIGHTS; i < HIDDEN_WEIGHTS + H2 * H1; i++) {
+            parameters[i] = clamp(parameters[i], -MAX_WEIGHT, MAX_WEIGHT);
+        }
+
+        for (int j = OUTPUT_WEIGHTS; j < OUTPUT_WEIGHTS + H2; j++) {
+            parameters[j] = clamp(parameters[j], -MAX_WEIGHT, MAX_WEIGHT);
+        }
+    }
+
+    /* Returns the network with rounded weights. */
+    QuantizedNetwork quantize() const {
+        constexpr double ACTIVATION_SCALE = QuantizedNetwork::ACTIVATION_SCALE;
+        constexpr double WEIGHT_SCALE = QuantizedNetwork::WEIGHT_SCALE;
+
+        typename QuantizedNetwork::Weights weights;
+        const double *p = parameters.data();
+
+        for (int k = 0; k < H1; k++) {
+            for (int i = 0; i < INPUTS; i++) {
+                weights.input_weights[i][k] = clamp<long>(lround(p[INPUT_WEIGHTS + i * H1 + k] * ACTIVATION_SCALE), INT16_MIN, INT16_MAX);
+            }
+
+            weights.input_biases[k] = clamp<long>(lround(p[INPUT_BIASES + k] * ACTIVATION_SCALE), INT16_MIN, INT16_MAX);
+        }
+
+        for (int j = 0; j < H2; j++) {
+            for (int k = 0; k < H1; k++) {
+                weights.hidden_weights[j][k] = clamp<long>(lround(p[HIDDEN_WEIGHTS + j * H1 + k] * WEIGHT_SCALE), -127, 127);
+            }
+
+            weights.hidden_biases[j] = lround(p[HIDDEN_BIASES + j] * ACTIVATION_SCALE * WEIGHT_SCALE);
+            weights.output_weights[j] = clamp<long>(lround(p[OUTPUT_WEIGHTS + j] * WEIGHT_SCALE), -127, 127);
+        }
+
+        weights.output_bias = lround(p[OUTPUT_BIAS] * ACTIVATION_SCALE * WEIGHT_SCALE);
+
+        QuantizedNetwork network;
+        network.set_weights(weights);
+        return network;
+    }
+};
+
+/* Runs f(thread index, begin, end) over equal slices of [0, n) on several threads. */
+template <class Function> void parallel_for(int threads, int n, Function f) {
+    vector<thread> workers;
+
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(f, i, static_cast<long long>(n) * i / threads, static_cast<long long>(n) * (i + 1) / threads);
+    }
+
+    for (thread &worker : workers) {
+        worker.join();
+    }
+}
+
+/* Returns the mean squared error of the samples. */
+template <int INPUTS> double get_loss(const FloatNetwork<INPUTS> &network, const vector<Sample> &samples, int threads) {
+    vector<double> losses(threads, 0.0);
+
+    parallel_for(threads, samples.size(), [&](int thread_index, long long begin, long long end) {
+        for (long long i = begin; i < end; i++) {
+            losses[thread_index] += network.get_loss(samples[i], nullptr);
+        }
+    });
+
+    return accumulate(losses.begin(), losses.end(), 0.0) / max<size_t>(1, samples.size());
+}
+
+/* Returns the mean squared error of the quantized network on the samples. */
+template <int INPUTS> double get_loss(const Network<INPUTS> &network, const vector<Sample> &samples) {
+    double loss = 0.0;
+
+    for (const Sample &sample : samples) {
+        bitset<INPUTS> inputs;
+
+        for (int input : sample.inputs) {
+            inputs.set(input);
+        }
+
+        double y = network.evaluate(inputs);
+        loss += (y - sample.result) * (y - sample.result);
+    }
+
+    return loss / max<size_t>(1, samples.size());
+}
+
+/* Trains the evaluation network of the game on self-play results and saves it quantized. */
+template <class GameType, class StateType = typename GameType::state_type> void train(const Options &options) {
+    constexpr int INPUTS = decltype(GameType::network)::INPUT_COUNT;
+
+    // Positions.
+    typename SelfPlay<GameType>::Settings settings;
+    settings.games = options.games;
+    settings.depth = options.depth;
+    settings.random_plies = options.random_plies;
+    settings.multi_pv = options.multi_pv;
+    settings.max_turns = options.max_turns;
+    settings.threads = options.threads;
+    settings.seed = options.seed;
+
+    chrono::time_point<chrono::high_resolution_clock> t_start = chrono::high_resolution_clock::now();
+    vector<typename SelfPlay<GameType>::Position> positions =
+        options.positions.has_value() ? SelfPlay<GameType>::load(options.positions.value()) : SelfPlay<GameType>::play(settings);
+    chrono::duration<double> t = chrono::high_resolution_clock::now() - t_start;
+    printf("%zu positions (%.3lfs)\n", positions.size(), t.count());
+
+    if (options.save_positions.has_value() and !SelfPlay<GameType>::save(options.save_positions.value(), positions)) {
+        fprintf(stderr, "Could not write %s\n", options.save_positions.value().c_str());
+    }
+
+    if (positions.empty()) {
+        return;
+    }
+
+    // Inputs.
+    vector<Sample> training, validation;
+
+    for (int i = 0; i < positions.size(); i++) {
+        bitset<INPUTS> inputs = GameType(StateType::deserialize(positions[i].state)).get_network_inputs();
+        Sample sample = {{}, static_cast<float>(2.0 * positions[i].result - 1.0)};
+
+        for (int input = inputs._Find_first(); input < INPUTS; input = inputs._Find_next(input)) {
+            sample.inputs.push_back(input);
+        }
+
+        (i % VALIDATION_INTERVAL == 0 ? validation : training).push_back(sample);
+    }
+
+    // Mini-batch gradient descent with Adam.
+    FloatNetwork<INPUTS> network(options.seed);
+    vector<double> moment1(network.SIZE, 0.0), moment2(network.SIZE, 0.0);
+    vector<vector<double>> gradients(options.threads, vector<double>(network.SIZE));
+    mt19937 rng(options.seed);
+    long long step = 0;
+
+    printf("%5s %14s %15s\n", "Epoch", "Training loss", "Validation loss");
+
+    for (int epoch = 1; epoch <= options.epochs; epoch++) {
+        shuffle(training.begin(), training.end(), rng);
+        double loss = 0.0;
+
+        for (int begin = 0; begin < training.size(); begin += options.batch_size) {
+            int size = min<int>(options.batch_size, training.size() - begin);
+            vector<double> losses(options.threads, 0.0);
+
+            parallel_for(options.threads, size, [&](int thread_index, long long thread_begin, long long thread_end) {
+                fill(gradients[thread_index].begin(), gradients[thread_index].end(), 0.0);
+
+                for (long long i = thread_begin; i < thread_end; i++) {
+                    losses[thread_index] += network.get_loss(training[begin + i], &gradients[thread_index]);
+                }
+            });
+
+            loss += accumulate(losses.begin(), losses.end(), 0.0);
+            step++;
+
+            for (int i = 0; i < network.SIZE; i++) {
+                double gradient = 0.0;
+
+                for (int j = 0; j < options.threads; j++) {
+                    gradient += gradients[j][i];
+                }
+
+                gradient /= size;
+                moment1[i] = ADAM_BETA1 * moment1[i] + (1.0 - ADAM_BETA1) * gradient;
+                moment2[i] = ADAM_BETA2 * moment2[i] + (1.0 - ADAM_BETA2) * gradient * gradient;
+                double corrected_moment1 = moment1[i] / (1.0 - pow(ADAM_BETA1, step));
+                double corrected_moment2 = moment2[i] / (1.0 - pow(ADAM_BETA2, step));
+                network.parameters[i] -= options.learning_rate * corrected_moment1 / (sqrt(corrected_moment2) + ADAM_EPSILON);
+            }
+
+            network.clip();
+        }
+
+        printf("%5d %14.6lf %15.6lf\n", epoch, loss / training.size(), get_loss(network, validation, options.threads));
+    }
+
+    // Saving.
+    Network<INPUTS> quantized_network = network.quantize();
+    string output = options.output.value_or(NETWORKS_FOLDER_PATH + options.game_name + ".nn");
+    printf("Quantized validation loss: %.6lf\n", get_loss(quantized_network, validation));
+
+    if (!quantized_network.save(output)) {
+        fprintf(stderr, "Could not write %s\n", output.c_str());
+    }
+}
+
+/* Usage: train <game> [--games <n>] [--depth <plies>] [--random-plies <n>] [--multipv <n>] [--max-turns <n>] [--threads <n>]
+                [--epochs <n>] [--batch-size <n>] [--learning-rate <r>] [--positions <file>] [--save-positions <file>] [--output <file>] [--seed <n>] */
+int main(int argc, char *argv[]) {
+    Options options;
+    bool valid = argc > 1;
+
+    for (int i = 1; i < argc and valid; i++) {
+        string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--games" and has_value) {
+            options.games = max(1, atoi(argv[++i]));
+        } else if (arg == "--depth" and has_value) {
+            options.depth = max(1, atoi(argv[++i]));
+        } else if (arg == "--random-plies" and has_value) {
+            options.random_plies = max(0, atoi(argv[++i]));
+        } else if (arg == "--multipv" and has_value) {
+            options.multi_pv = max(1, atoi(argv[++i]));
+        } else if (arg == "--max-turns" and has_value) {
+            options.max_turns = max(1, atoi(argv[++i]));
+        } else if (arg == "--threads" and has_value) {
+            options.threads = max(1, atoi(argv[++i]));
+        } else if (arg == "--epochs" and has_value) {
+            options.epochs = max(0, atoi(argv[++i]));
+        } else if (arg == "--batch-size" and has_value) {
+            options.batch_size = max(1, atoi(argv[++i]));
+        } else if (arg == "--learning-rate" and has_value) {
+            options.learning_rate = atof(argv[++i]);
+        } else if (arg == "--positions" and has_value) {
+            options.positions = argv[++i];
+        } else if (arg == "--save-positions" and has_value) {
+            options.save_positions = argv[++i];
+        } else if (arg == "--output" and has_value) {
+            options.output = argv[++i];
+        } else if (arg == "--seed" and has_value) {
+            options.seed = strtoul(argv[++i], nullptr, 10);
+        } else if (options.game_name.empty() and arg.rfind("--", 0) != 0) {
+            options.game_name = arg;
+        } else {
+            valid = false;
+        }
+    }
+
+    if (!valid) {
+        printf("Usage: train <game> [--games <n>] [--depth <plies>] [--random-plies <n>] [--multipv <n>] [--max-turns <n>] [--threads <n>]\n");
+        printf("             [--epochs <n>] [--batch-size <n>] [--learning-rate <r>] [--positions <file>] [--save-positions <file>] [--output <file>] [--seed <n>]\n");
+        return 1;
+    }
+
+    // Self-play uses the current evaluation, so that every network learns from the previous one.
+    Parameters::load(PARAMETERS_PATH);
+    BaghChalGame::network.load(NETWORKS_FOLDER_PATH + "BaghChal.nn");
+    KonaneGame::network.load(NETWORKS_FOLDER_PATH + "Konane.nn");
+
+    if (options.game_name == "BaghChal") {
+        train<BaghChalGame>(options);
+    } else if (options.game_name == "Konane") {
+        train<KonaneGame>(options);
+    } else {
+        printf("%s has no evaluation network\n", options.game_name.c_str());
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+#ifdef __linux__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/* Common. */
+#include <TranspositionTable.hpp>
+
+using namespace std;
+
+/* Constants. */
+constexpr size_t MEGABYTES = 1;
+constexpr unsigned TIMEOUT_SECONDS = 10;
+const string TAG = "ttfile";
+
+#ifdef __linux__
+/* Returns an entry that can be told apart from the others by its score. */
+TranspositionTable::Entry make_entry(int score) {
+    TranspositionTable::Entry entry;
+    entry.move = 1;
+    entry.score = score;
+    entry.height = 1;
+    return entry;
+}
+
+/* Returns true if the table has the entry of make_entry(score) for the hash. */
+bool has_entry(const TranspositionTable &table, size_t hash, int score) {
+    optional<TranspositionTable::Entry> entry = table.probe(hash);
+    return entry.has_value() and entry->score == score;
+}
+
+/* Runs a function in a child process. Returns false if it returns false or doesn't finish in TIMEOUT_SECONDS, as when opening the file blocks. */
+bool run_process(const function<bool()> &function_) {
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        alarm(TIMEOUT_SECONDS);
+        _exit(function_() ? 0 : 1);
+    }
+
+    int status = 0;
+    return pid > 0 and waitpid(pid, &status, 0) == pid and WIFEXITED(status) and WEXITSTATUS(status) == 0;
+}
+
+/* Runs a check on a new file and prints if it passed. */
+bool check(const string &name, const function<bool(const string &)> &function_) {
+    string path = (filesystem::temp_directory_path() / ("ttfile-" + to_string(getpid()) + ".tt")).string();
+    filesystem::remove(path);
+
+    bool ok = run_process([&]() { return function_(path); });
+    filesystem::remove(path);
+    printf("%-48s %s\n", name.c_str(), ok ? "OK" : "FAILED");
+    fflush(stdout);
+    return ok;
+}
+
+/* Two tables of the same process map the file at once and see each other's entries. */
+bool check_same_process(const string &path) {
+    TranspositionTable first(MEGABYTES), second(MEGABYTES);
+
+    if (!first.open(path, MEGABYTES, TAG) or !second.open(path, MEGABYTES, TAG)) {
+        return false;
+    }
+
+    first.store(1, make_entry(10));
+    second.store(2, make_entry(20));
+    return has_entry(second, 1, 10) and has_entry(first, 2, 20);
+}
+
+/* While this process keeps the file mapped, other processes map it for writing and read only, and they all see the stored entries. */
+bool check_other_processes(const string &path) {
+    TranspositionTable table(MEGABYTES);
+
+    if (!table.open(path, MEGABYTES, TAG)) {
+        return false;
+    }
+
+    table.store(1, make_entry(10));
+
+    bool writer = run_process([&]() {
+        TranspositionTable other(MEGABYTES);
+
+        if (!other.open(path, MEGABYTES, TAG) or !has_entry(other, 1, 10)) {
+            return false;
+        }
+
+        other.store(2, make_entry(20));
+        return true;
+    });
+
+    bool reader = run_process([&]() {
+        TranspositionTable other(MEGABYTES);
+        return other.open(path, MEGABYTES, TAG, true) and has_entry(other, 1, 10) and has_entry(other, 2, 20);
+    });
+
+    return writer and reader and has_entry(table, 2, 20);
+}
+
+/* A table of another game can't reset the file while this process maps it, and leaves its entries alone. It resets the file once it is unmapped. */
+bool check_reset(const string &path) {
+    const string other_tag = TAG + " other game";
+
+    {
+        TranspositionTable table(MEGABYTES);
+
+        if (!table.open(path, MEGABYTES, TAG)) {
+            return false;
+        }
+
+        table.store(1, make_entry(10));
+
+        bool refused = run_process([&]() {
+            TranspositionTable other(MEGABYTES);
+            return !other.open(path, MEGABYTES, other_tag);
+        });
+
+        if (!refused or !has_entry(table, 1, 10)) {
+            return false;
+        }
+    }
+
+    return run_process([&]() {
+        TranspositionTable other(MEGABYTES);
+        return other.open(path, MEGABYTES, other_tag) and !other.probe(1).has_value();
+    });
+}
+#endif
+
+/* Usage: ttfile
+   Checks that transposition table files can be mapped by several tables and processes at once. */
+int main() {
+#ifdef __linux__
+    bool ok = check("Two tables in the same process", check_same_process);
+    ok = check("Writing and read only tables in other processes", check_other_processes) and ok;
+    ok = check("Resets only when no other table maps the file", check_reset) and ok;
+    return ok ? 0 : 1;
+#else
+    printf("Transposition table files are only supported on Linux\n");
+    return 0;
+#endif
+}
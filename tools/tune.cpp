@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Common. */
+#include <Game.hpp>
+#include <Minimax.hpp>
+#include <Parameters.hpp>
+#include <SelfPlay.hpp>
+
+/* Games. */
+#include <BaghChalGame.hpp>
+#include <ConnectFourGame.hpp>
+
+using namespace std;
+
+/* Constants. */
+const string PARAMETERS_PATH = "data/params.txt";
+constexpr double SCALE = 4.0;          // Win probability of PLAYER_MAX is modeled as sigmoid(SCALE * evaluation).
+constexpr int VALIDATION_INTERVAL = 10; // One in VALIDATION_INTERVAL positions is kept out of training.
+constexpr double ADAM_BETA1 = 0.9, ADAM_BETA2 = 0.999, ADAM_EPSILON = 1e-8;
+
+/* Command line options. */
+class Options {
+  public:
+    string game_name;
+    int games = 1000;
+    int depth = 4;
+    int random_plies = 8;
+    int multi_pv = 1;
+    int max_turns = 200;
+    int threads = max(1u, thread::hardware_concurrency());
+    int iterations = 2000;
+    double learning_rate = 0.001;
+    optional<string> positions = nullopt;
+    optional<string> save_positions = nullopt;
+    string output = PARAMETERS_PATH;
+    unsigned int seed = 0;
+};
+
+/* Features of a position with the result of its game. */
+template <class GameType> class Sample {
+  public:
+    array<double, GameType::FEATURES> features;
+    double result;
+};
+
+/* Returns the logistic function. */
+double sigmoid(double x) {
+    return 1.0 / (1.0 + exp(-x));
+}
+
+/* Runs f(thread index, begin, end) over equal slices of [0, n) on several threads. */
+template <class Function> void parallel_for(int threads, int n, Function f) {
+    vector<thread> workers;
+
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(f, i, static_cast<long long>(n) * i / threads, static_cast<long long>(n) * (i + 1) / threads);
+    }
+
+    for (thread &worker : workers) {
+        worker.join();
+    }
+}
+
+/* Returns the average logistic loss of the samples, and adds its gradient to the given array if any. */
+template <class GameType, size_t FEATURES = GameType::FEATURES>
+double get_loss(const vector<Sample<GameType>> &samples, const array<double, GameType::FEATURES> &weights, int threads, array<double, GameType::FEATURES> *gradient) {
+    vector<double> losses(threads, 0.0);
+    vector<array<double, FEATURES>> gradients(threads);
+
+    parallel_for(threads, samples.size(), [&](int thread_index, long long begin, long long end) {
+        gradients[thread_index].fill(0.0);
+
+        for (long long i = begin; i < end; i++) {
+            double evaluation = 0.0;
+
+            for (int j = 0; j < FEATURES; j++) {
+                evaluation += samples[i].features[j] * weights[j];
+            }
+
+            double p = clamp(sigmoid(SCALE * evaluation), 1e-12, 1.0 - 1e-12);
+            losses[thread_index] -= samples[i].result * log(p) + (1.0 - samples[i].result) * log(1.0 - p);
+
+            for (int j = 0; j < FEATURES; j++) {
+                gradients[thread_index][j] += (p - samples[i].result) * SCALE * samples[i].features[j];
+            }
+        }
+    });
+
+    double loss = 0.0;
+
+    for (int i = 0; i < threads; i++) {
+        loss += losses[i];
+
+        for (int j = 0; gradient != nullptr and j < FEATURES; j++) {
+            (*gradient)[j] += gradients[i][j] / samples.size();
+        }
+    }
+
+    return loss / max<size_t>(1, samples.size());
+}
+
+/* Fits the evaluation weights of the game to self-play results and saves them to the parameter file. */
+template <class GameType, class StateType = typename GameType::state_type, size_t FEATURES = GameType::FEATURES> void tune(const Options &options) {
+    // Positions.
+    chrono::time_point<chrono::high_resolution_clock> t_start = chrono::high_resolution_clock::now();
+    typename SelfPlay<GameType>::Settings settings;
+    settings.games = options.games;
+    settings.depth = options.depth;
+    settings.random_plies = options.random_plies;
+    settings.multi_pv = options.multi_pv;
+    settings.max_turns = options.max_turns;
+    settings.threads = options.threads;
+    settings.seed = options.seed;
+
+    vector<typename SelfPlay<GameType>::Position> positions =
+        options.positions.has_value() ? SelfPlay<GameType>::load(options.positions.value()) : SelfPlay<GameType>::play(settings);
+    chrono::duration<double> t = chrono::high_resolution_clock::now() - t_start;
+    printf("%zu positions (%.3lfs)\n", positions.size(), t.count());
+
+    if (options.save_positions.has_value() and !SelfPlay<GameType>::save(options.save_positions.value(), positions)) {
+        fprintf(stderr, "Could not write %s\n", options.save_positions.value().c_str());
+    }
+
+    if (positions.empty()) {
+        return;
+    }
+
+    // Features.
+    vector<Sample<GameType>> samples(positions.size()), training, validation;
+
+    parallel_for(options.threads, positions.size(), [&](int, long long begin, long long end) {
+        for (long long i = begin; i < end; i++) {
+            samples[i].features = GameType(StateType::deserialize(positions[i].state)).get_features();
+            samples[i].result = positions[i].result;
+        }
+    });
+
+    for (int i = 0; i < samples.size(); i++) {
+        (i % VALIDATION_INTERVAL == 0 ? validation : training).push_back(samples[i]);
+    }
+
+    // Gradient descent with Adam, since features have very different scales.
+    array<double, FEATURES> weights, moment1 = {}, moment2 = {};
+
+    for (int j = 0; j < FEATURES; j++) {
+        weights[j] = GameType::weights[j].get();
+    }
+
+    printf("%9s %14s %15s\n", "Iteration", "Training loss", "Validation loss");
+    printf("%9d %14.6lf %15.6lf\n", 0, get_loss<GameType>(training, weights, options.threads, nullptr),
+           get_loss<GameType>(validation, weights, options.threads, nullptr));
+
+    for (int iteration = 1; iteration <= options.iterations; iteration++) {
+        array<double, FEATURES> gradient = {};
+        double loss = get_loss<GameType>(training, weights, options.threads, &gradient);
+
+        for (int j = 0; j < FEATURES; j++) {
+            moment1[j] = ADAM_BETA1 * moment1[j] + (1.0 - ADAM_BETA1) * gradient[j];
+            moment2[j] = ADAM_BETA2 * moment2[j] + (1.0 - ADAM_BETA2) * gradient[j] * gradient[j];
+            double corrected_moment1 = moment1[j] / (1.0 - pow(ADAM_BETA1, iteration));
+            double corrected_moment2 = moment2[j] / (1.0 - pow(ADAM_BETA2, iteration));
+            weights[j] -= options.learning_rate * corrected_moment1 / (sqrt(corrected_moment2) + ADAM_EPSILON);
+        }
+
+        if (iteration % 100 == 0 or iteration == options.iterations) {
+            printf("%9d %14.6lf %15.6lf\n", iteration, loss, get_loss<GameType>(validation, weights, options.threads, nullptr));
+        }
+    }
+
+    // Saving.
+    for (int j = 0; j < FEATURES; j++) {
+        GameType::weights[j].set(weights[j]);
+        printf("%s = %.9g\n", GameType::weights[j].get_name().c_str(), weights[j]);
+    }
+
+    if (!Parameters::save(options.output)) {
+        fprintf(stderr, "Could not write %s\n", options.output.c_str());
+    }
+}
+
+/* Usage: tune <game> [--games <n>] [--depth <plies>] [--random-plies <n>] [--multipv <n>] [--max-turns <n>] [--threads <n>]
+               [--iterations <n>] [--learning-rate <r>] [--positions <file>] [--save-positions <file>] [--output <file>] [--seed <n>] */
+int main(int argc, char *argv[]) {
+    Options options;
+    bool valid = argc > 1;
+
+    for (int i = 1; i < argc and valid; i++) {
+        string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--games" and has_value) {
+            options.games = max(1, atoi(argv[++i]));
+        } else if (arg == "--depth" and has_value) {
+            options.depth = max(1, atoi(argv[++i]));
+        } else if (arg == "--random-plies" and has_value) {
+            options.random_plies = max(0, atoi(argv[++i]));
+        } else if (arg == "--multipv" and has_value) {
+            options.multi_pv = max(1, atoi(argv[++i]));
+        } else if (arg == "--max-turns" and has_value) {
+            options.max_turns = max(1, atoi(argv[++i]));
+        } else if (arg == "--threads" and has_value) {
+            options.threads = max(1, atoi(argv[++i]));
+        } else if (arg == "--iterations" and has_value) {
+            options.iterations = max(0, atoi(argv[++i]));
+        } else if (arg == "--learning-rate" and has_value) {
+            options.learning_rate = atof(argv[++i]);
+        } else if (arg == "--positions" and has_value) {
+            options.positions = argv[++i];
+        } else if (arg == "--save-positions" and has_value) {
+            options.save_positions = argv[++i];
+        } else if (arg == "--output" and has_value) {
+            options.output = argv[++i];
+        } else if (arg == "--seed" and has_value) {
+            options.seed = strtoul(argv[++i], nullptr, 10);
+        } else if (options.game_name.empty() and arg.rfind("--", 0) != 0) {
+            options.game_name = arg;
+        } else {
+            valid = false;
+        }
+    }
+
+    if (!valid) {
+        printf("Usage: tune <game> [--games <n>] [--depth <plies>] [--random-plies <n>] [--multipv <n>] [--max-turns <n>] [--threads <n>]\n");
+        printf("            [--iterations <n>] [--learning-rate <r>] [--positions <file>] [--save-positions <file>] [--output <file>] [--seed <n>]\n");
+        return 1;
+    }
+
+    // Self-play uses the current weights.
+    Parameters::load(PARAMETERS_PATH);
+
+    if (options.game_name == "BaghChal") {
+        tune<BaghChalGame>(options);
+    } else if (options.game_name == "ConnectFour") {
+        tune<ConnectFourGame>(options);
+    } else {
+        printf("%s has no evaluation parameters\n", options.game_name.c_str());
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file